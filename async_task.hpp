@@ -0,0 +1,146 @@
+#pragma once
+
+#include "loop_queue.hpp"
+#include "worker_pool.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#include <type_traits>
+#include <utility>
+
+namespace phosphor::certs
+{
+
+/** @class Task
+ *  @brief Coroutine started right away on the event loop thread and
+ *  detached from its caller. It runs until it awaits work on a worker
+ *  thread, so many of them can be in flight on the single loop thread.
+ *  @details The body is expected to report its own errors, an exception
+ *  escaping the coroutine is only logged.
+ */
+class Task
+{
+  public:
+    struct promise_type
+    {
+        Task get_return_object() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {}
+
+        void unhandled_exception() noexcept
+        {
+            using ::phosphor::logging::entry;
+            using ::phosphor::logging::level;
+            using ::phosphor::logging::log;
+            try
+            {
+                throw;
+            }
+            catch (const std::exception& e)
+            {
+                log<level::ERR>("Asynchronous task failed",
+                                entry("ERR=%s", e.what()));
+            }
+            catch (...)
+            {
+                log<level::ERR>("Asynchronous task failed");
+            }
+        }
+    };
+};
+
+/** @class WorkerAwaiter
+ *  @brief Runs a job on a worker thread while the awaiting coroutine is
+ *  suspended, the coroutine resumes on the event loop thread.
+ *  @details The coroutine resumes with a future holding the job result or
+ *  the exception it threw. If the event loop queue is destroyed before the
+ *  coroutine could resume, its frame is destroyed instead.
+ */
+template <typename Job>
+class WorkerAwaiter
+{
+  public:
+    using Result = std::invoke_result_t<Job&>;
+
+    /** @brief Constructor
+     *  @param[in] pool - Worker threads to run the job on.
+     *  @param[in] loop - Queue of the event loop to resume on.
+     *  @param[in] job - Callable to run on a worker thread.
+     */
+    WorkerAwaiter(WorkerPool& pool, LoopQueue& loop, Job&& job) :
+        pool(pool), loop(loop), task(std::move(job))
+    {}
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        auto resumer = std::make_shared<Resumer>(handle);
+        pool.submit([this, resumer]() {
+            task();
+            loop.post([resumer]() { resumer->resume(); });
+        });
+    }
+
+    std::future<Result> await_resume()
+    {
+        return task.get_future();
+    }
+
+  private:
+    /** @brief Owns the suspended coroutine until it is resumed */
+    struct Resumer
+    {
+        explicit Resumer(std::coroutine_handle<> handle) : handle(handle)
+        {}
+
+        Resumer(const Resumer&) = delete;
+        Resumer& operator=(const Resumer&) = delete;
+
+        ~Resumer()
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+        }
+
+        void resume()
+        {
+            std::exchange(handle, nullptr).resume();
+        }
+
+        std::coroutine_handle<> handle;
+    };
+
+    /** @brief Worker threads */
+    WorkerPool& pool;
+
+    /** @brief Event loop queue */
+    LoopQueue& loop;
+
+    /** @brief Job and its result */
+    std::packaged_task<Result()> task;
+};
+
+} // namespace phosphor::certs
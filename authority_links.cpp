@@ -0,0 +1,239 @@
+#include "config.h"
+
+#include "authority_links.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+} // namespace
+
+AuthorityLinks::AuthorityLinks(const std::string& directory) :
+    directory(directory)
+{
+    dirFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0)
+    {
+        log<level::ERR>("Failed to open certificate directory",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("DIRECTORY=%s", directory.c_str()));
+        elog<InternalFailure>();
+    }
+}
+
+AuthorityLinks::~AuthorityLinks()
+{
+    if (dirFd >= 0)
+    {
+        close(dirFd);
+    }
+}
+
+std::string AuthorityLinks::linkName(const std::string& subjectHash,
+                                     size_t index)
+{
+    return subjectHash + "." + std::to_string(index);
+}
+
+void AuthorityLinks::reset()
+{
+    slots.clear();
+    hashes.clear();
+
+    // Directory stream gets its own descriptor, closedir() closes it.
+    int fd = openat(dirFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR* dir = (fd < 0) ? nullptr : fdopendir(fd);
+    if (dir == nullptr)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        log<level::ERR>("Failed to read certificate directory",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("DIRECTORY=%s", directory.c_str()));
+        elog<InternalFailure>();
+    }
+
+    std::vector<std::string> links;
+    while (struct dirent* ent = readdir(dir))
+    {
+        bool isLink = (ent->d_type == DT_LNK);
+        if (ent->d_type == DT_UNKNOWN)
+        {
+            struct stat st = {};
+            isLink = (fstatat(dirFd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW) ==
+                      0) &&
+                     S_ISLNK(st.st_mode);
+        }
+        if (isLink)
+        {
+            links.emplace_back(ent->d_name);
+        }
+    }
+    closedir(dir);
+
+    Watch::Suppression suppression(watch);
+    for (const auto& link : links)
+    {
+        if (unlinkat(dirFd, link.c_str(), 0) < 0 && errno != ENOENT)
+        {
+            log<level::ERR>("Failed to remove symlink for certificate",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("SYMLINK=%s", link.c_str()));
+            elog<InternalFailure>();
+        }
+        suppression.written(link);
+    }
+}
+
+void AuthorityLinks::add(const std::string& certFilePath,
+                         const std::string& subjectHash)
+{
+    auto& chain = slots[subjectHash];
+    if (chain.size() >= maxNumAuthorityCertificates)
+    {
+        log<level::ERR>("Authority certificate x509 file path already used",
+                        entry("DIR=%s", directory.c_str()));
+        elog<InternalFailure>();
+    }
+
+    const std::string link = linkName(subjectHash, chain.size());
+    Watch::Suppression suppression(watch);
+    int rc = symlinkat(certFilePath.c_str(), dirFd, link.c_str());
+    if (rc < 0 && errno == EEXIST)
+    {
+        // Left over from something outside of the model, take the slot.
+        if (unlinkat(dirFd, link.c_str(), 0) == 0)
+        {
+            rc = symlinkat(certFilePath.c_str(), dirFd, link.c_str());
+        }
+    }
+    if (rc < 0)
+    {
+        log<level::ERR>("Failed to create symlink for certificate",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("FILE=%s", certFilePath.c_str()),
+                        entry("SYMLINK=%s", link.c_str()));
+        elog<InternalFailure>();
+    }
+    suppression.written(link);
+
+    chain.push_back(certFilePath);
+    hashes[certFilePath] = subjectHash;
+}
+
+void AuthorityLinks::remove(const std::string& certFilePath)
+{
+    auto hashIt = hashes.find(certFilePath);
+    if (hashIt == hashes.end())
+    {
+        return;
+    }
+    const std::string subjectHash = hashIt->second;
+    hashes.erase(hashIt);
+
+    auto& chain = slots[subjectHash];
+    auto pos = std::find(chain.begin(), chain.end(), certFilePath);
+    if (pos == chain.end())
+    {
+        return;
+    }
+    const size_t index = static_cast<size_t>(pos - chain.begin());
+    const size_t last = chain.size() - 1;
+    const std::string link = linkName(subjectHash, index);
+
+    Watch::Suppression suppression(watch);
+    if (index == last)
+    {
+        if (unlinkat(dirFd, link.c_str(), 0) < 0 && errno != ENOENT)
+        {
+            log<level::ERR>("Failed to remove symlink for certificate",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("SYMLINK=%s", link.c_str()));
+            elog<InternalFailure>();
+        }
+        suppression.written(link);
+    }
+    else
+    {
+        // Move the last link over the removed one, replacing it atomically.
+        const std::string lastLink = linkName(subjectHash, last);
+        if (renameat(dirFd, lastLink.c_str(), dirFd, link.c_str()) < 0)
+        {
+            log<level::ERR>("Failed to move symlink for certificate",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("SRC=%s", lastLink.c_str()),
+                            entry("DST=%s", link.c_str()));
+            elog<InternalFailure>();
+        }
+        suppression.written(lastLink);
+        suppression.written(link);
+        *pos = std::move(chain.back());
+    }
+
+    chain.pop_back();
+    if (chain.empty())
+    {
+        slots.erase(subjectHash);
+    }
+}
+
+void AuthorityLinks::update(const std::string& certFilePath,
+                            const std::string& subjectHash)
+{
+    auto hashIt = hashes.find(certFilePath);
+    if (hashIt != hashes.end() && hashIt->second == subjectHash)
+    {
+        return;
+    }
+    remove(certFilePath);
+    add(certFilePath, subjectHash);
+}
+
+void AuthorityLinks::clear()
+{
+    Watch::Suppression suppression(watch);
+    for (const auto& [subjectHash, chain] : slots)
+    {
+        for (size_t index = 0; index < chain.size(); ++index)
+        {
+            const std::string link = linkName(subjectHash, index);
+            if (unlinkat(dirFd, link.c_str(), 0) < 0 && errno != ENOENT)
+            {
+                log<level::ERR>("Failed to remove symlink for certificate",
+                                entry("ERR=%s", std::strerror(errno)),
+                                entry("SYMLINK=%s", link.c_str()));
+            }
+            suppression.written(link);
+        }
+    }
+    slots.clear();
+    hashes.clear();
+}
+
+void AuthorityLinks::setWatch(Watch* dirWatch)
+{
+    watch = dirWatch;
+}
+
+} // namespace phosphor::certs
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "watch.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @class AuthorityLinks
+ *  @brief Maintains OpenSSL style hash links in the authority directory.
+ *  @details OpenSSL looks up CA certificates in a directory by symbolic
+ *  links named <subject_hash>.<n>, where n has to be a consecutive integer
+ *  for certificates sharing the same subject name hash. This class keeps an
+ *  in-memory model of that namespace so that adding or removing a single
+ *  certificate only touches the links of its own subject hash, using system
+ *  calls relative to a directory file descriptor held open for the lifetime
+ *  of the object.
+ */
+class AuthorityLinks
+{
+  public:
+    AuthorityLinks() = delete;
+    AuthorityLinks(const AuthorityLinks&) = delete;
+    AuthorityLinks& operator=(const AuthorityLinks&) = delete;
+    AuthorityLinks(AuthorityLinks&&) = delete;
+    AuthorityLinks& operator=(AuthorityLinks&&) = delete;
+
+    /** @brief Constructor
+     *  @param[in] directory - Authority certificate directory.
+     */
+    explicit AuthorityLinks(const std::string& directory);
+
+    /** @brief Destructor, links are left in place. */
+    ~AuthorityLinks();
+
+    /** @brief Remove every symbolic link from the directory and forget the
+     *  model. Used when the directory state is unknown, e.g. at startup.
+     */
+    void reset();
+
+    /** @brief Create the hash link for a certificate file.
+     *  @param[in] certFilePath - Certificate file the link points to.
+     *  @param[in] subjectHash - Subject name hash of the certificate.
+     */
+    void add(const std::string& certFilePath, const std::string& subjectHash);
+
+    /** @brief Remove the hash link of a certificate file. The last link of
+     *  the same subject hash is moved into the freed slot to keep the
+     *  numbering consecutive.
+     *  @param[in] certFilePath - Certificate file the link points to.
+     */
+    void remove(const std::string& certFilePath);
+
+    /** @brief Update the hash link after the certificate file content has
+     *  changed. Nothing is done when the subject hash stays the same.
+     *  @param[in] certFilePath - Certificate file the link points to.
+     *  @param[in] subjectHash - New subject name hash of the certificate.
+     */
+    void update(const std::string& certFilePath,
+                const std::string& subjectHash);
+
+    /** @brief Remove every link managed by the model. */
+    void clear();
+
+    /** @brief Report link changes as own changes to the watch of the
+     *  directory, so that they do not call back.
+     *  @param[in] dirWatch - Directory watch, may be null.
+     */
+    void setWatch(Watch* dirWatch);
+
+  private:
+    /** @brief Compose link name from hash and slot index */
+    static std::string linkName(const std::string& subjectHash, size_t index);
+
+    /** @brief Certificate directory path, for logging */
+    std::string directory;
+
+    /** @brief Certificate directory file descriptor */
+    int dirFd = -1;
+
+    /** @brief Watch of the directory, not owned */
+    Watch* watch = nullptr;
+
+    /** @brief Certificate file paths by subject hash, in link slot order */
+    std::unordered_map<std::string, std::vector<std::string>> slots;
+
+    /** @brief Subject hash by certificate file path */
+    std::unordered_map<std::string, std::string> hashes;
+};
+
+} // namespace phosphor::certs
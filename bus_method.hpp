@@ -0,0 +1,82 @@
+#pragma once
+
+#include <systemd/sd-bus.h>
+
+#include <exception>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/exception.hpp>
+#include <utility>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+// Methods that phosphor-dbus-interfaces does not define are registered with
+// plain sd-bus vtables next to the generated interfaces.
+
+using BusSlotPtr = std::unique_ptr<sd_bus_slot, decltype(&::sd_bus_slot_unref)>;
+using BusMessagePtr =
+    std::unique_ptr<sd_bus_message, decltype(&::sd_bus_message_unref)>;
+using BusCallPtr = std::shared_ptr<sd_bus_message>;
+
+/** @brief Keep a method call around to reply to it once deferred work is
+ *  done. The handler returns without replying in that case.
+ *  @param[in] msg - Method call being handled.
+ */
+inline BusCallPtr holdBusMethod(sd_bus_message* msg)
+{
+    return BusCallPtr(sd_bus_message_ref(msg), ::sd_bus_message_unref);
+}
+
+/** @brief Run the body of a vtable method handler, turning exceptions into
+ *  D-Bus errors the same way the generated server bindings do.
+ *  @param[out] error - Error returned to the caller.
+ *  @param[in] body - Reads the arguments, does the work and replies.
+ *  @return Result of the body or negative errno of the error set.
+ */
+template <typename Body>
+int handleBusMethod(sd_bus_error* error, Body&& body)
+{
+    try
+    {
+        return body();
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        return sd_bus_error_set(error, e.name(), e.description());
+    }
+    catch (const std::exception& e)
+    {
+        using ::phosphor::logging::entry;
+        using ::phosphor::logging::level;
+        using ::phosphor::logging::log;
+        log<level::ERR>("Method call failed", entry("ERR=%s", e.what()));
+        sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure
+            failure;
+        return sd_bus_error_set(error, failure.name(), failure.description());
+    }
+}
+
+/** @brief Finish a method call whose reply was deferred, errors are sent
+ *  back the same way handleBusMethod reports them.
+ *  @param[in] call - Method call held by holdBusMethod.
+ *  @param[in] body - Does the remaining work and replies.
+ */
+template <typename Body>
+void completeBusMethod(sd_bus_message* call, Body&& body)
+{
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    int r = handleBusMethod(&error, std::forward<Body>(body));
+    if (r < 0)
+    {
+        if (!sd_bus_error_is_set(&error))
+        {
+            sd_bus_error_set_errno(&error, -r);
+        }
+        sd_bus_reply_method_error(call, &error);
+    }
+    sd_bus_error_free(&error);
+}
+
+} // namespace phosphor::certs
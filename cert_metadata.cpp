@@ -0,0 +1,283 @@
+#include "cert_metadata.hpp"
+
+#include "crypto_context.hpp"
+#include "x509_utils.hpp"
+
+#include <arpa/inet.h>
+#include <openssl/asn1.h>
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/objects.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+// RAII support for openSSL functions.
+using BIOMemPtr = std::unique_ptr<BIO, decltype(&::BIO_free)>;
+using ASN1TimePtr = std::unique_ptr<ASN1_TIME, decltype(&ASN1_STRING_free)>;
+
+// Refer to schema 2018.3
+// http://redfish.dmtf.org/schemas/v1/Certificate.json#/definitions/KeyUsage for
+// supported KeyUsage types in redfish
+// Refer to
+// https://github.com/openssl/openssl/blob/master/include/openssl/x509v3.h for
+// key usage bit fields
+constexpr std::array<std::pair<uint32_t, std::string_view>, 9>
+    keyUsageToRfStr = {{{KU_DIGITAL_SIGNATURE, "DigitalSignature"},
+                        {KU_NON_REPUDIATION, "NonRepudiation"},
+                        {KU_KEY_ENCIPHERMENT, "KeyEncipherment"},
+                        {KU_DATA_ENCIPHERMENT, "DataEncipherment"},
+                        {KU_KEY_AGREEMENT, "KeyAgreement"},
+                        {KU_KEY_CERT_SIGN, "KeyCertSign"},
+                        {KU_CRL_SIGN, "CRLSigning"},
+                        {KU_ENCIPHER_ONLY, "EncipherOnly"},
+                        {KU_DECIPHER_ONLY, "DecipherOnly"}}};
+
+// Refer to schema 2018.3
+// http://redfish.dmtf.org/schemas/v1/Certificate.json#/definitions/KeyUsage for
+// supported Extended KeyUsage types in redfish
+constexpr std::array<std::pair<int, std::string_view>, 6>
+    extendedKeyUsageToRfStr = {{{NID_server_auth, "ServerAuthentication"},
+                                {NID_client_auth, "ClientAuthentication"},
+                                {NID_email_protect, "EmailProtection"},
+                                {NID_OCSP_sign, "OCSPSigning"},
+                                {NID_ad_timeStamping, "Timestamping"},
+                                {NID_code_sign, "CodeSigning"}}};
+
+// Names used for the public key algorithms, others use the OpenSSL short name
+constexpr std::array<std::pair<int, std::string_view>, 6> keyTypeNames = {
+    {{EVP_PKEY_RSA, "RSA"},
+     {EVP_PKEY_RSA_PSS, "RSA-PSS"},
+     {EVP_PKEY_EC, "EC"},
+     {EVP_PKEY_DSA, "DSA"},
+     {EVP_PKEY_ED25519, "Ed25519"},
+     {EVP_PKEY_ED448, "Ed448"}}};
+
+std::string hexString(const ASN1_STRING* value)
+{
+    if (value == nullptr)
+    {
+        return {};
+    }
+    return toHex(ASN1_STRING_get0_data(value),
+                 static_cast<size_t>(ASN1_STRING_length(value)));
+}
+
+std::string fingerprint(X509& cert, const EVP_MD* type)
+{
+    std::array<unsigned char, EVP_MAX_MD_SIZE> md{};
+    unsigned int length = 0;
+    if (X509_digest(&cert, type, md.data(), &length) != 1)
+    {
+        return {};
+    }
+    return toHex(md.data(), length);
+}
+
+void addKeyUsage(X509& cert, std::vector<std::string>& keyUsage)
+{
+    if ((X509_get_extension_flags(&cert) & EXFLAG_KUSAGE) == 0)
+    {
+        return;
+    }
+    const uint32_t usage = X509_get_key_usage(&cert);
+    for (const auto& [bit, name] : keyUsageToRfStr)
+    {
+        if ((usage & bit) != 0)
+        {
+            keyUsage.emplace_back(name);
+        }
+    }
+}
+
+void addExtendedKeyUsage(X509& cert, std::vector<std::string>& keyUsage)
+{
+    auto extUsage = static_cast<EXTENDED_KEY_USAGE*>(
+        X509_get_ext_d2i(&cert, NID_ext_key_usage, nullptr, nullptr));
+    if (extUsage == nullptr)
+    {
+        return;
+    }
+    for (int i = 0; i < sk_ASN1_OBJECT_num(extUsage); i++)
+    {
+        const int nid = OBJ_obj2nid(sk_ASN1_OBJECT_value(extUsage, i));
+        // Usages Redfish has no name for are not reported
+        for (const auto& [usageNid, name] : extendedKeyUsageToRfStr)
+        {
+            if (usageNid == nid)
+            {
+                keyUsage.emplace_back(name);
+                break;
+            }
+        }
+    }
+    EXTENDED_KEY_USAGE_free(extUsage);
+}
+
+std::string ipAddressString(const ASN1_OCTET_STRING* address)
+{
+    std::array<char, INET6_ADDRSTRLEN> buffer{};
+    const int length = ASN1_STRING_length(address);
+    const int family = length == 4 ? AF_INET : length == 16 ? AF_INET6 : 0;
+    if (family == 0 || inet_ntop(family, ASN1_STRING_get0_data(address),
+                                 buffer.data(), buffer.size()) == nullptr)
+    {
+        return {};
+    }
+    return buffer.data();
+}
+
+std::vector<std::string> subjectAltNames(X509& cert)
+{
+    std::vector<std::string> names;
+    auto generalNames = static_cast<GENERAL_NAMES*>(
+        X509_get_ext_d2i(&cert, NID_subject_alt_name, nullptr, nullptr));
+    if (generalNames == nullptr)
+    {
+        return names;
+    }
+    for (int i = 0; i < sk_GENERAL_NAME_num(generalNames); i++)
+    {
+        const GENERAL_NAME* name = sk_GENERAL_NAME_value(generalNames, i);
+        const ASN1_STRING* value = nullptr;
+        std::string prefix;
+        switch (name->type)
+        {
+            case GEN_DNS:
+                prefix = "DNS:";
+                value = name->d.dNSName;
+                break;
+            case GEN_EMAIL:
+                prefix = "email:";
+                value = name->d.rfc822Name;
+                break;
+            case GEN_URI:
+                prefix = "URI:";
+                value = name->d.uniformResourceIdentifier;
+                break;
+            case GEN_IPADD:
+            {
+                std::string address = ipAddressString(name->d.iPAddress);
+                if (!address.empty())
+                {
+                    names.emplace_back("IP:" + address);
+                }
+                continue;
+            }
+            default:
+                continue;
+        }
+        names.emplace_back(
+            prefix +
+            std::string(
+                reinterpret_cast<const char*>(ASN1_STRING_get0_data(value)),
+                static_cast<size_t>(ASN1_STRING_length(value))));
+    }
+    GENERAL_NAMES_free(generalNames);
+    return names;
+}
+
+uint64_t toEpochSeconds(const ASN1_TIME* time)
+{
+    static const uint64_t dayToSeconds = 24 * 60 * 60;
+    int days = 0;
+    int secs = 0;
+
+    ASN1TimePtr epoch(ASN1_TIME_new(), ASN1_STRING_free);
+    // Set time to 00:00am GMT, Jan 1 1970; format: YYYYMMDDHHMMSSZ
+    ASN1_TIME_set_string(epoch.get(), "19700101000000Z");
+    ASN1_TIME_diff(&days, &secs, epoch.get(), time);
+    return (days * dayToSeconds) + secs;
+}
+
+std::string printName(X509_NAME* name)
+{
+    static const int maxKeySize = 4096;
+    char buffer[maxKeySize] = {0};
+    BIOMemPtr bio(BIO_new(BIO_s_mem()), BIO_free);
+    X509_NAME_print_ex(bio.get(), name, 0, XN_FLAG_SEP_COMMA_PLUS);
+    BIO_read(bio.get(), buffer, maxKeySize - 1);
+    return buffer;
+}
+} // namespace
+
+CertificateIdentity extractIdentity(X509& x509)
+{
+    CertificateIdentity identity;
+    identity.certId = generateCertId(x509);
+    identity.digest = generateCertDigest(x509);
+    identity.subjectNameHash = generateSubjectNameHash(x509);
+    identity.validNotAfter = toEpochSeconds(X509_get0_notAfter(&x509));
+    return identity;
+}
+
+CertificateMetadata extractMetadata(X509& x509)
+{
+    X509* cert = &x509;
+    CertificateMetadata metadata;
+
+    BIOMemPtr certBio(BIO_new(BIO_s_mem()), BIO_free);
+    PEM_write_bio_X509(certBio.get(), cert);
+    BUF_MEM* buf = nullptr;
+    BIO_get_mem_ptr(certBio.get(), &buf);
+    metadata.certificateString.assign(buf->data, buf->length);
+
+    // These pointers cannot be freed independently.
+    metadata.subject = printName(X509_get_subject_name(cert));
+    metadata.issuer = printName(X509_get_issuer_name(cert));
+
+    addKeyUsage(x509, metadata.keyUsage);
+    addExtendedKeyUsage(x509, metadata.keyUsage);
+
+    metadata.validNotAfter = toEpochSeconds(X509_get0_notAfter(cert));
+    metadata.validNotBefore = toEpochSeconds(X509_get0_notBefore(cert));
+
+    metadata.serialNumber = hexString(X509_get0_serialNumber(cert));
+    metadata.fingerprintSHA256 =
+        fingerprint(x509, CryptoContext::get().sha256());
+    metadata.fingerprintSHA1 = fingerprint(x509, CryptoContext::get().sha1());
+    metadata.subjectAltNames = subjectAltNames(x509);
+    metadata.subjectKeyIdentifier = hexString(X509_get0_subject_key_id(cert));
+    metadata.authorityKeyIdentifier =
+        hexString(X509_get0_authority_key_id(cert));
+
+    if (EVP_PKEY* key = X509_get0_pubkey(cert); key != nullptr)
+    {
+        const int keyType = EVP_PKEY_base_id(key);
+        if (const char* name = OBJ_nid2sn(keyType); name != nullptr)
+        {
+            metadata.keyType = name;
+        }
+        for (const auto& [nid, name] : keyTypeNames)
+        {
+            if (nid == keyType)
+            {
+                metadata.keyType = name;
+                break;
+            }
+        }
+        metadata.keySize = static_cast<uint64_t>(EVP_PKEY_bits(key));
+    }
+
+    if (const char* name = OBJ_nid2ln(X509_get_signature_nid(cert));
+        name != nullptr)
+    {
+        metadata.signatureAlgorithm = name;
+    }
+
+    return metadata;
+}
+
+} // namespace phosphor::certs
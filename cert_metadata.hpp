@@ -0,0 +1,96 @@
+#pragma once
+
+#include <openssl/x509.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @struct CertificateIdentity
+ *  @brief What the service itself needs to know about an installed
+ *  certificate. It is cheap to derive and kept for the lifetime of the
+ *  certificate object.
+ */
+struct CertificateIdentity
+{
+    /** @brief Certificate ID, see generateCertId() */
+    std::string certId;
+
+    /** @brief SHA-256 digest of the DER encoding */
+    std::string digest;
+
+    /** @brief Subject name hash used for authority links */
+    std::string subjectNameHash;
+
+    /** @brief End of the validity period, seconds since the epoch */
+    uint64_t validNotAfter = 0;
+};
+
+/** @struct CertificateMetadata
+ *  @brief Values of the certificate D-Bus properties. They are only
+ *  decoded when a client asks for them.
+ */
+struct CertificateMetadata
+{
+    /** @brief PEM encoding of the certificate */
+    std::string certificateString;
+
+    /** @brief Subject distinguished name */
+    std::string subject;
+
+    /** @brief Issuer distinguished name */
+    std::string issuer;
+
+    /** @brief Key usage and extended key usage, Redfish names */
+    std::vector<std::string> keyUsage;
+
+    /** @brief Start of the validity period, seconds since the epoch */
+    uint64_t validNotBefore = 0;
+
+    /** @brief End of the validity period, seconds since the epoch */
+    uint64_t validNotAfter = 0;
+
+    /** @brief Serial number, hex */
+    std::string serialNumber;
+
+    /** @brief SHA-256 digest of the DER encoding, hex */
+    std::string fingerprintSHA256;
+
+    /** @brief SHA-1 digest of the DER encoding, hex */
+    std::string fingerprintSHA1;
+
+    /** @brief Subject alternative names, e.g. "DNS:bmc.example.com" */
+    std::vector<std::string> subjectAltNames;
+
+    /** @brief Subject key identifier, hex, empty if not present */
+    std::string subjectKeyIdentifier;
+
+    /** @brief Authority key identifier, hex, empty if not present */
+    std::string authorityKeyIdentifier;
+
+    /** @brief Public key algorithm, e.g. "RSA" or "EC" */
+    std::string keyType;
+
+    /** @brief Public key size in bits */
+    uint64_t keySize = 0;
+
+    /** @brief Signature algorithm, e.g. "sha256WithRSAEncryption" */
+    std::string signatureAlgorithm;
+};
+
+/** @brief Derive the certificate identity.
+ *  @param[in] cert - Certificate.
+ *  @return Certificate identity.
+ */
+CertificateIdentity extractIdentity(X509& cert);
+
+/** @brief Decode all certificate D-Bus property values in one pass.
+ *  @param[in] cert - Certificate.
+ *  @return Certificate metadata.
+ */
+CertificateMetadata extractMetadata(X509& cert);
+
+} // namespace phosphor::certs
@@ -3,30 +3,27 @@
 #include "certificate.hpp"
 
 #include "certs_manager.hpp"
+#include "publish.hpp"
 
-#include <openssl/asn1.h>
 #include <openssl/bio.h>
-#include <openssl/buffer.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
-#include <openssl/obj_mac.h>
-#include <openssl/objects.h>
-#include <openssl/opensslv.h>
 #include <openssl/pem.h>
-#include <openssl/ssl3.h>
-#include <openssl/x509v3.h>
 
+#include <array>
+#include <cerrno>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
-#include <ctime>
+#include <cstring>
 #include <exception>
 #include <filesystem>
-#include <fstream>
-#include <map>
+#include <initializer_list>
+#include <memory>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <watch.hpp>
@@ -51,65 +48,169 @@ using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 
 // RAII support for openSSL functions.
 using BIOMemPtr = std::unique_ptr<BIO, decltype(&::BIO_free)>;
-using X509StorePtr = std::unique_ptr<X509_STORE, decltype(&::X509_STORE_free)>;
-using X509StoreCtxPtr =
-    std::unique_ptr<X509_STORE_CTX, decltype(&::X509_STORE_CTX_free)>;
-using ASN1TimePtr = std::unique_ptr<ASN1_TIME, decltype(&ASN1_STRING_free)>;
-using EVPPkeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
-using BufMemPtr = std::unique_ptr<BUF_MEM, decltype(&::BUF_MEM_free)>;
-
-// Trust chain related errors.`
-#define TRUST_CHAIN_ERR(errnum)                                                \
-    ((errnum == X509_V_ERR_DEPTH_ZERO_SELF_SIGNED_CERT) ||                     \
-     (errnum == X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN) ||                       \
-     (errnum == X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY) ||               \
-     (errnum == X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT) ||                       \
-     (errnum == X509_V_ERR_CERT_UNTRUSTED) ||                                  \
-     (errnum == X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE))
-
-// Refer to schema 2018.3
-// http://redfish.dmtf.org/schemas/v1/Certificate.json#/definitions/KeyUsage for
-// supported KeyUsage types in redfish
-// Refer to
-// https://github.com/openssl/openssl/blob/master/include/openssl/x509v3.h for
-// key usage bit fields
-std::map<uint8_t, std::string> keyUsageToRfStr = {
-    {KU_DIGITAL_SIGNATURE, "DigitalSignature"},
-    {KU_NON_REPUDIATION, "NonRepudiation"},
-    {KU_KEY_ENCIPHERMENT, "KeyEncipherment"},
-    {KU_DATA_ENCIPHERMENT, "DataEncipherment"},
-    {KU_KEY_AGREEMENT, "KeyAgreement"},
-    {KU_KEY_CERT_SIGN, "KeyCertSign"},
-    {KU_CRL_SIGN, "CRLSigning"},
-    {KU_ENCIPHER_ONLY, "EncipherOnly"},
-    {KU_DECIPHER_ONLY, "DecipherOnly"}};
-
-// Refer to schema 2018.3
-// http://redfish.dmtf.org/schemas/v1/Certificate.json#/definitions/KeyUsage for
-// supported Extended KeyUsage types in redfish
-std::map<uint8_t, std::string> extendedKeyUsageToRfStr = {
-    {NID_server_auth, "ServerAuthentication"},
-    {NID_client_auth, "ClientAuthentication"},
-    {NID_email_protect, "EmailProtection"},
-    {NID_OCSP_sign, "OCSPSigning"},
-    {NID_ad_timeStamping, "Timestamping"},
-    {NID_code_sign, "CodeSigning"}};
-} // namespace
 
-std::string Certificate::generateCertId(const std::string& certPath)
+constexpr auto replaceDataInterface = "xyz.openbmc_project.Certs.ReplaceData";
+
+int replaceFdHandler(sd_bus_message* msg, void* userdata, sd_bus_error* error)
 {
-    const internal::X509Ptr cert = loadCert(certPath);
-    unsigned long subjectNameHash = X509_subject_name_hash(cert.get());
-    unsigned long issuerSerialHash = X509_issuer_and_serial_hash(cert.get());
-    static constexpr auto CERT_ID_LENGTH = 17;
-    char idBuff[CERT_ID_LENGTH];
+    return handleBusMethod(error, [msg, userdata]() {
+        int fd = -1;
+        int r = sd_bus_message_read(msg, "h", &fd);
+        if (r < 0)
+        {
+            return r;
+        }
+        static_cast<Certificate*>(userdata)->replaceAsync(
+            msg, fileDescriptorReader(fd));
+        return 1;
+    });
+}
 
-    snprintf(idBuff, CERT_ID_LENGTH, "%08lx%08lx", subjectNameHash,
-             issuerSerialHash);
+int replacePEMHandler(sd_bus_message* msg, void* userdata, sd_bus_error* error)
+{
+    return handleBusMethod(error, [msg, userdata]() {
+        const char* pem = nullptr;
+        int r = sd_bus_message_read(msg, "s", &pem);
+        if (r < 0)
+        {
+            return r;
+        }
+        static_cast<Certificate*>(userdata)->replaceAsync(
+            msg, [data = std::string(pem)]() { return data; });
+        return 1;
+    });
+}
 
-    return std::string(idBuff);
+const sd_bus_vtable replaceDataVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("ReplaceFromFd", "h", "", replaceFdHandler,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_METHOD("ReplaceFromPEM", "s", "", replacePEMHandler,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_VTABLE_END};
+
+constexpr auto detailsInterface = "xyz.openbmc_project.Certs.Details";
+
+// String properties of the details interface
+constexpr std::array<std::pair<std::string_view,
+                               std::string CertificateMetadata::*>,
+                     7>
+    detailsStrings = {{
+        {"SerialNumber", &CertificateMetadata::serialNumber},
+        {"FingerprintSHA256", &CertificateMetadata::fingerprintSHA256},
+        {"FingerprintSHA1", &CertificateMetadata::fingerprintSHA1},
+        {"SubjectKeyIdentifier", &CertificateMetadata::subjectKeyIdentifier},
+        {"AuthorityKeyIdentifier",
+         &CertificateMetadata::authorityKeyIdentifier},
+        {"KeyType", &CertificateMetadata::keyType},
+        {"SignatureAlgorithm", &CertificateMetadata::signatureAlgorithm},
+    }};
+
+int detailsGetter(sd_bus*, const char*, const char*, const char* property,
+                  sd_bus_message* reply, void* userdata, sd_bus_error* error)
+{
+    return handleBusMethod(error, [property, reply, userdata]() {
+        const CertificateMetadata& details =
+            static_cast<Certificate*>(userdata)->getProperties();
+        const std::string_view name(property);
+        if (name == "KeySize")
+        {
+            return sd_bus_message_append(reply, "t", details.keySize);
+        }
+        if (name == "SubjectAlternativeNames")
+        {
+            int r = sd_bus_message_open_container(reply, 'a', "s");
+            for (const auto& altName : details.subjectAltNames)
+            {
+                if (r >= 0)
+                {
+                    r = sd_bus_message_append(reply, "s", altName.c_str());
+                }
+            }
+            return r < 0 ? r : sd_bus_message_close_container(reply);
+        }
+        for (const auto& [stringName, member] : detailsStrings)
+        {
+            if (stringName == name)
+            {
+                return sd_bus_message_append(reply, "s",
+                                             (details.*member).c_str());
+            }
+        }
+        return -ENOENT;
+    });
 }
 
+const sd_bus_vtable detailsVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_PROPERTY("SerialNumber", "s", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("FingerprintSHA256", "s", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("FingerprintSHA1", "s", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("SubjectAlternativeNames", "as", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("SubjectKeyIdentifier", "s", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("AuthorityKeyIdentifier", "s", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("KeyType", "s", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("KeySize", "t", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_PROPERTY("SignatureAlgorithm", "s", detailsGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_INVALIDATION),
+    SD_BUS_VTABLE_END};
+
+using BusMessagePtr =
+    std::unique_ptr<sd_bus_message, decltype(&::sd_bus_message_unref)>;
+
+// Interfaces of a certificate object, as sd-bus lists them
+constexpr std::array<const char*, 8> objectInterfaces = {
+    "org.freedesktop.DBus.Peer",
+    "org.freedesktop.DBus.Introspectable",
+    "org.freedesktop.DBus.Properties",
+    sdbusplus::xyz::openbmc_project::Certs::server::Certificate::interface,
+    sdbusplus::xyz::openbmc_project::Certs::server::Replace::interface,
+    sdbusplus::xyz::openbmc_project::Object::server::Delete::interface,
+    replaceDataInterface,
+    detailsInterface,
+};
+
+// Signal the given properties as invalidated, without their values
+int emitInvalidated(sd_bus* bus, const char* path, const char* interface,
+                    std::initializer_list<const char*> properties)
+{
+    sd_bus_message* m = nullptr;
+    int r = sd_bus_message_new_signal(bus, &m, path,
+                                      "org.freedesktop.DBus.Properties",
+                                      "PropertiesChanged");
+    BusMessagePtr msg(m, ::sd_bus_message_unref);
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(m, "sa{sv}", interface, 0);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_open_container(m, 'a', "s");
+    }
+    for (const char* property : properties)
+    {
+        if (r >= 0)
+        {
+            r = sd_bus_message_append(m, "s", property);
+        }
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_close_container(m);
+    }
+    return r < 0 ? r : sd_bus_send(bus, m, nullptr);
+}
+
+} // namespace
+
 std::string
     Certificate::generateUniqueFilePath(const std::string& directoryPath)
 {
@@ -126,32 +227,6 @@ std::string
     return filePathStr;
 }
 
-std::string Certificate::generateAuthCertFileX509Path(
-    const std::string& certSrcFilePath, const std::string& certDstDirPath)
-{
-    const internal::X509Ptr cert = loadCert(certSrcFilePath);
-    unsigned long hash = X509_subject_name_hash(cert.get());
-    static constexpr auto CERT_HASH_LENGTH = 9;
-    char hashBuf[CERT_HASH_LENGTH];
-
-    snprintf(hashBuf, CERT_HASH_LENGTH, "%08lx", hash);
-
-    const std::string certHash(hashBuf);
-    for (size_t i = 0; i < maxNumAuthorityCertificates; ++i)
-    {
-        const std::string certDstFileX509Path =
-            certDstDirPath + "/" + certHash + "." + std::to_string(i);
-        if (!fs::exists(certDstFileX509Path))
-        {
-            return certDstFileX509Path;
-        }
-    }
-
-    log<level::ERR>("Authority certificate x509 file path already used",
-                    entry("DIR=%s", certDstDirPath.c_str()));
-    elog<InternalFailure>();
-}
-
 std::string
     Certificate::generateAuthCertFilePath(const std::string& certSrcFilePath)
 {
@@ -190,203 +265,141 @@ std::string
 
 Certificate::Certificate(sdbusplus::bus::bus& bus, const std::string& objPath,
                          CertificateType type, const std::string& installPath,
-                         const std::string& uploadPath, Watch* watch,
+                         CertificateContent&& content, Watch* watch,
                          Manager& parent) :
     internal::CertificateInterface(bus, objPath.c_str(), true),
-    objectPath(objPath), certType(type), certInstallPath(installPath),
-    certWatch(watch), manager(parent)
+    bus(bus), objectPath(objPath), certType(type),
+    certInstallPath(installPath), certWatch(watch), manager(parent)
 {
-    auto installHelper = [this](const auto& filePath) {
-        if (!compareKeys(filePath))
-        {
-            elog<InvalidCertificateError>(InvalidCertificate::REASON(
-                "Private key does not match the Certificate"));
-        };
-    };
-    typeFuncMap[CertificateType::Server] = installHelper;
-    typeFuncMap[CertificateType::Client] = installHelper;
-    typeFuncMap[CertificateType::Authority] = [](const std::string&) {};
-
-    auto appendPrivateKey = [this](const std::string& filePath) {
-        checkAndAppendPrivateKey(filePath);
-    };
-
-    appendKeyMap[CertificateType::Server] = appendPrivateKey;
-    appendKeyMap[CertificateType::Client] = appendPrivateKey;
-    appendKeyMap[CertificateType::Authority] = [](const std::string&) {};
+    initialize(bus);
 
     // Generate certificate file path
-    certFilePath = generateCertFilePath(uploadPath);
+    certFilePath = generateCertFilePath(content.sourcePath);
 
     // install the certificate
-    install(uploadPath);
+    install(std::move(content));
 
-    this->emit_object_added();
-}
-
-Certificate::~Certificate()
-{
-    if (!fs::remove(certFilePath))
+    if (!manager.signalsDeferred())
     {
-        log<level::INFO>("Certificate file not found!",
-                         entry("PATH=%s", certFilePath.c_str()));
+        flushSignals();
     }
 }
 
-void Certificate::replace(const std::string filePath)
-{
-    manager.replaceCertificate(this, filePath);
-}
-
-void Certificate::install(const std::string& certSrcFilePath)
+Certificate::Certificate(sdbusplus::bus::bus& bus, const std::string& objPath,
+                         CertificateType type, const std::string& installPath,
+                         const std::string& filePath,
+                         CertificateIdentity&& identity, Watch* watch,
+                         Manager& parent) :
+    internal::CertificateInterface(bus, objPath.c_str(), true),
+    bus(bus), objectPath(objPath), certType(type),
+    certInstallPath(installPath), certFilePath(filePath),
+    identity(std::move(identity)), certWatch(watch), manager(parent)
 {
-    log<level::INFO>("Certificate install ",
-                     entry("FILEPATH=%s", certSrcFilePath.c_str()));
-    auto errCode = X509_V_OK;
-
-    // stop watch for user initiated certificate install
-    if (certWatch != nullptr)
-    {
-        certWatch->stopWatch();
-    }
-
-    // Verify the certificate file
-    fs::path file(certSrcFilePath);
-    if (!fs::exists(file))
+    initialize(bus);
+    if (!manager.signalsDeferred())
     {
-        log<level::ERR>("File is Missing",
-                        entry("FILE=%s", certSrcFilePath.c_str()));
-        elog<InternalFailure>();
+        flushSignals();
     }
+}
 
-    try
-    {
-        if (fs::file_size(certSrcFilePath) == 0)
+void Certificate::initialize(sdbusplus::bus::bus& bus)
+{
+    auto installHelper = [](const CertificateContent& content) {
+        log<level::INFO>("Certificate compareKeys",
+                         entry("FILEPATH=%s", content.sourcePath.c_str()));
+        if (!content.privateKey)
         {
-            // file is empty
-            log<level::ERR>("File is empty",
-                            entry("FILE=%s", certSrcFilePath.c_str()));
+            log<level::ERR>("Error occurred during PEM_read_bio_PrivateKey",
+                            entry("FILE=%s", content.sourcePath.c_str()));
             elog<InvalidCertificateError>(
-                InvalidCertificate::REASON("File is empty"));
+                InvalidCertificate::REASON("Failed to get private key info"));
         }
-    }
-    catch (const fs::filesystem_error& e)
-    {
-        // Log Error message
-        log<level::ERR>(e.what(), entry("FILE=%s", certSrcFilePath.c_str()));
-        elog<InternalFailure>();
-    }
-
-    // Create an empty X509_STORE structure for certificate validation.
-    X509StorePtr x509Store(X509_STORE_new(), &X509_STORE_free);
-    if (!x509Store)
-    {
-        log<level::ERR>("Error occurred during X509_STORE_new call");
-        elog<InternalFailure>();
-    }
+        if (!compareKeys(*content.cert, *content.privateKey))
+        {
+            elog<InvalidCertificateError>(InvalidCertificate::REASON(
+                "Private key does not match the Certificate"));
+        };
+    };
+    typeFuncMap[CertificateType::Server] = installHelper;
+    typeFuncMap[CertificateType::Client] = installHelper;
+    typeFuncMap[CertificateType::Authority] = [](const CertificateContent&) {};
 
-    OpenSSL_add_all_algorithms();
+    auto appendPrivateKey = [this](CertificateContent& content) {
+        checkAndAppendPrivateKey(content);
+    };
 
-    // ADD Certificate Lookup method.
-    // lookup will be cleaned up automatically when the holding Store goes away.
-    auto lookup = X509_STORE_add_lookup(x509Store.get(), X509_LOOKUP_file());
+    appendKeyMap[CertificateType::Server] = appendPrivateKey;
+    appendKeyMap[CertificateType::Client] = appendPrivateKey;
+    appendKeyMap[CertificateType::Authority] = [](CertificateContent&) {};
 
-    if (!lookup)
+    sd_bus_slot* slot = nullptr;
+    int r = sd_bus_add_object_vtable(bus.get(), &slot, objectPath.c_str(),
+                                     replaceDataInterface, replaceDataVtable,
+                                     this);
+    if (r < 0)
     {
-        log<level::ERR>("Error occurred during X509_STORE_add_lookup call");
-        elog<InternalFailure>();
+        log<level::ERR>("Failed to register replace from data methods",
+                        entry("ERR=%s", std::strerror(-r)),
+                        entry("PATH=%s", objectPath.c_str()));
     }
-    // Load Certificate file.
-    errCode = X509_LOOKUP_load_file(lookup, certSrcFilePath.c_str(),
-                                    X509_FILETYPE_PEM);
-    if (errCode != 1)
+    replaceDataSlot.reset(slot);
+
+    slot = nullptr;
+    r = sd_bus_add_object_vtable(bus.get(), &slot, objectPath.c_str(),
+                                 detailsInterface, detailsVtable, this);
+    if (r < 0)
     {
-        log<level::ERR>("Error occurred during X509_LOOKUP_load_file call",
-                        entry("FILE=%s", certSrcFilePath.c_str()));
-        elog<InvalidCertificateError>(
-            InvalidCertificate::REASON("Invalid certificate file format"));
+        log<level::ERR>("Failed to register certificate details",
+                        entry("ERR=%s", std::strerror(-r)),
+                        entry("PATH=%s", objectPath.c_str()));
     }
+    detailsSlot.reset(slot);
+}
 
-    // Load Certificate file into the X509 structure.
-    internal::X509Ptr cert = loadCert(certSrcFilePath);
-    X509StoreCtxPtr storeCtx(X509_STORE_CTX_new(), ::X509_STORE_CTX_free);
-    if (!storeCtx)
+Certificate::~Certificate()
+{
+    if (published)
     {
-        log<level::ERR>("Error occurred during X509_STORE_CTX_new call",
-                        entry("FILE=%s", certSrcFilePath.c_str()));
-        elog<InternalFailure>();
+        sd_bus_emit_object_removed(bus.get(), objectPath.c_str());
     }
+}
 
-    errCode = X509_STORE_CTX_init(storeCtx.get(), x509Store.get(), cert.get(),
-                                  nullptr);
-    if (errCode != 1)
+void Certificate::removeFile()
+{
+    // The removal is the service's own change, not one to reconcile
+    Watch::Suppression suppression(certWatch);
+    if (!fs::remove(certFilePath))
     {
-        log<level::ERR>("Error occurred during X509_STORE_CTX_init call",
-                        entry("FILE=%s", certSrcFilePath.c_str()));
-        elog<InternalFailure>();
+        log<level::INFO>("Certificate file not found!",
+                         entry("PATH=%s", certFilePath.c_str()));
     }
+    suppression.written(certFilePath);
+}
 
-    // Set time to current time.
-    auto locTime = time(nullptr);
-
-    X509_STORE_CTX_set_time(storeCtx.get(), X509_V_FLAG_USE_CHECK_TIME,
-                            locTime);
+void Certificate::replace(const std::string filePath)
+{
+    manager.replaceCertificate(this, filePath);
+}
 
-    errCode = X509_verify_cert(storeCtx.get());
-    if (errCode == 1)
-    {
-        errCode = X509_V_OK;
-    }
-    else if (errCode == 0)
-    {
-        errCode = X509_STORE_CTX_get_error(storeCtx.get());
-        log<level::INFO>(
-            "Error occurred during X509_verify_cert call, checking for known "
-            "error",
-            entry("FILE=%s", certSrcFilePath.c_str()),
-            entry("ERRCODE=%d", errCode),
-            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
-    }
-    else
-    {
-        log<level::ERR>("Error occurred during X509_verify_cert call",
-                        entry("FILE=%s", certSrcFilePath.c_str()));
-        elog<InternalFailure>();
-    }
+void Certificate::replace(CertificateContent&& content)
+{
+    manager.replaceCertificate(this, std::move(content));
+}
 
-    // Allow certificate upload, for "certificate is not yet valid" and
-    // trust chain related errors.
-    if (!((errCode == X509_V_OK) ||
-          (errCode == X509_V_ERR_CERT_NOT_YET_VALID) ||
-          TRUST_CHAIN_ERR(errCode)))
-    {
-        if (errCode == X509_V_ERR_CERT_HAS_EXPIRED)
-        {
-            log<level::ERR>("Expired certificate ");
-            elog<InvalidCertificateError>(
-                InvalidCertificate::REASON("Expired Certificate"));
-        }
-        // Logging general error here.
-        log<level::ERR>(
-            "Certificate validation failed", entry("ERRCODE=%d", errCode),
-            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
-        elog<InvalidCertificateError>(
-            InvalidCertificate::REASON("Certificate validation failed"));
-    }
+void Certificate::replaceAsync(sd_bus_message* call,
+                               std::function<std::string()>&& read)
+{
+    manager.replaceCertificateAsync(this, call, std::move(read));
+}
 
-    validateCertificateStartDate(*cert);
+void Certificate::install(CertificateContent&& content)
+{
+    const std::string& certSrcFilePath = content.sourcePath;
+    log<level::INFO>("Certificate install ",
+                     entry("FILEPATH=%s", certSrcFilePath.c_str()));
 
-    // Verify that the certificate can be used in a TLS context
-    const SSL_METHOD* method = TLS_method();
-    std::unique_ptr<SSL_CTX, decltype(&::SSL_CTX_free)> ctx(SSL_CTX_new(method),
-                                                            SSL_CTX_free);
-    if (SSL_CTX_use_certificate(ctx.get(), cert.get()) != 1)
-    {
-        log<level::ERR>("Certificate is not usable",
-                        entry("ERRCODE=%x", ERR_get_error()));
-        elog<InvalidCertificateError>(
-            InvalidCertificate::REASON("Certificate is not usable"));
-    }
+    // user initiated certificate install must not call back as a change
+    Watch::Suppression suppression(certWatch);
 
     // Invoke type specific append private key function.
     auto appendIter = appendKeyMap.find(certType);
@@ -396,7 +409,8 @@ void Certificate::install(const std::string& certSrcFilePath)
                         entry("TYPE=%s", certificateTypeToString(certType)));
         elog<InternalFailure>();
     }
-    appendIter->second(certSrcFilePath);
+    const size_t sourceSize = content.pem.size();
+    appendIter->second(content);
 
     // Invoke type specific compare keys function.
     auto compIter = typeFuncMap.find(certType);
@@ -406,352 +420,237 @@ void Certificate::install(const std::string& certSrcFilePath)
                         entry("TYPE=%s", certificateTypeToString(certType)));
         elog<InternalFailure>();
     }
-    compIter->second(certSrcFilePath);
+    compIter->second(content);
 
-    // Copy the certificate to the installation path
+    // Write the certificate to the installation path
     // During bootup will be parsing existing file so no need to
-    // copy it.
-    if (certSrcFilePath != certFilePath)
-    {
-        std::ifstream inputCertFileStream;
-        std::ofstream outputCertFileStream;
-        inputCertFileStream.exceptions(std::ifstream::failbit |
-                                       std::ifstream::badbit |
-                                       std::ifstream::eofbit);
-        outputCertFileStream.exceptions(std::ofstream::failbit |
-                                        std::ofstream::badbit |
-                                        std::ofstream::eofbit);
-
-        try
-        {
-            inputCertFileStream.open(certSrcFilePath);
-            outputCertFileStream.open(certFilePath, std::ios::out);
-            outputCertFileStream << inputCertFileStream.rdbuf() << std::flush;
-            inputCertFileStream.close();
-            outputCertFileStream.close();
-        }
-        catch (const std::exception& e)
-        {
-            log<level::ERR>("Failed to copy certificate",
-                            entry("ERR=%s", e.what()),
-                            entry("SRC=%s", certSrcFilePath.c_str()),
-                            entry("DST=%s", certFilePath.c_str()));
-            elog<InternalFailure>();
-        }
+    // write it, unless the private key had to be appended.
+    // The bytes written are the ones parsed and verified, not a second read
+    // of the source file, which may have changed in the meantime.
+    if (certSrcFilePath != certFilePath || content.pem.size() != sourceSize)
+    {
+        // A file carrying a private key is readable by the owner only
+        publishFile(certFilePath, content.pem,
+                    content.privateKey ? 0600 : 0644);
+        suppression.written(certFilePath);
     }
 
-    storageUpdate();
+    // The property values are decoded from the file when they are read
+    identity = extractIdentity(*content.cert);
+    invalidateProperties();
+}
 
-    // Keep certificate ID
-    certId = generateCertId(certFilePath);
+void Certificate::populateProperties()
+{
+    CertificateContent content = loadCertificate(certFilePath);
+    identity = extractIdentity(*content.cert);
+    invalidateProperties();
+}
 
-    // Parse the certificate file and populate properties
-    populateProperties(certFilePath);
+void Certificate::refresh(CertificateIdentity&& newIdentity)
+{
+    identity = std::move(newIdentity);
+    invalidateProperties();
+}
 
-    // restart watch
-    if (certWatch != nullptr)
-    {
-        certWatch->startWatch();
-    }
+std::string Certificate::certificateString() const
+{
+    return getProperties().certificateString;
 }
 
-// Checks that notBefore is not earlier than the unix epoch given that
-// the corresponding DBus interface is uint64_t.
-void Certificate::validateCertificateStartDate(X509& cert)
+std::vector<std::string> Certificate::keyUsage() const
 {
-    int days = 0;
-    int secs = 0;
+    return getProperties().keyUsage;
+}
 
-    ASN1TimePtr epoch(ASN1_TIME_new(), ASN1_STRING_free);
-    // Set time to 00:00am GMT, Jan 1 1970; format: YYYYMMDDHHMMSSZ
-    ASN1_TIME_set_string(epoch.get(), "19700101000000Z");
+std::string Certificate::issuer() const
+{
+    return getProperties().issuer;
+}
 
-    ASN1_TIME* notBefore = X509_get_notBefore(&cert);
-    ASN1_TIME_diff(&days, &secs, epoch.get(), notBefore);
+std::string Certificate::subject() const
+{
+    return getProperties().subject;
+}
 
-    if (days < 0 || secs < 0)
-    {
-        log<level::ERR>("Certificate valid date starts before the Unix Epoch");
-        elog<InvalidCertificateError>(InvalidCertificate::REASON(
-            "NotBefore should after 19700101000000Z"));
-    }
+uint64_t Certificate::validNotAfter() const
+{
+    return getProperties().validNotAfter;
 }
 
-void Certificate::populateProperties()
+uint64_t Certificate::validNotBefore() const
 {
-    populateProperties(certInstallPath);
+    return getProperties().validNotBefore;
 }
 
 std::string Certificate::getCertId() const
 {
-    return certId;
+    return identity.certId;
 }
 
-bool Certificate::isSame(const std::string& certPath)
+const std::string& Certificate::getCertDigest() const
 {
-    return getCertId() == generateCertId(certPath);
+    return identity.digest;
 }
 
-void Certificate::storageUpdate()
+const std::string& Certificate::getCertFilePath() const
 {
-    if (certType == CertificateType::Authority)
-    {
-        // Create symbolic link in the certificate directory
-        std::string certFileX509Path;
-        try
-        {
-            if (!certFilePath.empty() &&
-                fs::is_regular_file(fs::path(certFilePath)))
-            {
-                certFileX509Path =
-                    generateAuthCertFileX509Path(certFilePath, certInstallPath);
-                fs::create_symlink(fs::path(certFilePath),
-                                   fs::path(certFileX509Path));
-            }
-        }
-        catch (const std::exception& e)
-        {
-            log<level::ERR>("Failed to create symlink for certificate",
-                            entry("ERR=%s", e.what()),
-                            entry("FILE=%s", certFilePath.c_str()),
-                            entry("SYMLINK=%s", certFileX509Path.c_str()));
-            elog<InternalFailure>();
-        }
-    }
+    return certFilePath;
 }
 
-void Certificate::populateProperties(const std::string& certPath)
-{
-    internal::X509Ptr cert = loadCert(certPath);
-    // Update properties if no error thrown
-    BIOMemPtr certBio(BIO_new(BIO_s_mem()), BIO_free);
-    PEM_write_bio_X509(certBio.get(), cert.get());
-    BufMemPtr certBuf(BUF_MEM_new(), BUF_MEM_free);
-    BUF_MEM* buf = certBuf.get();
-    BIO_get_mem_ptr(certBio.get(), &buf);
-    std::string certStr(buf->data, buf->length);
-    certificateString(certStr);
-
-    static const int maxKeySize = 4096;
-    char subBuffer[maxKeySize] = {0};
-    BIOMemPtr subBio(BIO_new(BIO_s_mem()), BIO_free);
-    // This pointer cannot be freed independently.
-    X509_NAME* sub = X509_get_subject_name(cert.get());
-    X509_NAME_print_ex(subBio.get(), sub, 0, XN_FLAG_SEP_COMMA_PLUS);
-    BIO_read(subBio.get(), subBuffer, maxKeySize);
-    subject(subBuffer);
-
-    char issuerBuffer[maxKeySize] = {0};
-    BIOMemPtr issuerBio(BIO_new(BIO_s_mem()), BIO_free);
-    // This pointer cannot be freed independently.
-    X509_NAME* issuer_name = X509_get_issuer_name(cert.get());
-    X509_NAME_print_ex(issuerBio.get(), issuer_name, 0, XN_FLAG_SEP_COMMA_PLUS);
-    BIO_read(issuerBio.get(), issuerBuffer, maxKeySize);
-    issuer(issuerBuffer);
-
-    std::vector<std::string> keyUsageList;
-    ASN1_BIT_STRING* usage;
-
-    // Go through each usage in the bit string and convert to
-    // corresponding string value
-    if ((usage = static_cast<ASN1_BIT_STRING*>(
-             X509_get_ext_d2i(cert.get(), NID_key_usage, nullptr, nullptr))))
-    {
-        for (auto i = 0; i < usage->length; ++i)
-        {
-            for (auto& x : keyUsageToRfStr)
-            {
-                if (x.first & usage->data[i])
-                {
-                    keyUsageList.push_back(x.second);
-                    break;
-                }
-            }
-        }
-    }
-
-    EXTENDED_KEY_USAGE* extUsage;
-    if ((extUsage = static_cast<EXTENDED_KEY_USAGE*>(X509_get_ext_d2i(
-             cert.get(), NID_ext_key_usage, nullptr, nullptr))))
-    {
-        for (int i = 0; i < sk_ASN1_OBJECT_num(extUsage); i++)
-        {
-            keyUsageList.push_back(extendedKeyUsageToRfStr[OBJ_obj2nid(
-                sk_ASN1_OBJECT_value(extUsage, i))]);
-        }
-    }
-    keyUsage(keyUsageList);
-
-    int days = 0;
-    int secs = 0;
-
-    ASN1TimePtr epoch(ASN1_TIME_new(), ASN1_STRING_free);
-    // Set time to 00:00am GMT, Jan 1 1970; format: YYYYMMDDHHMMSSZ
-    ASN1_TIME_set_string(epoch.get(), "19700101000000Z");
+const std::string& Certificate::getObjectPath() const
+{
+    return objectPath;
+}
 
-    static const uint64_t dayToSeconds = 24 * 60 * 60;
-    ASN1_TIME* notAfter = X509_get_notAfter(cert.get());
-    ASN1_TIME_diff(&days, &secs, epoch.get(), notAfter);
-    validNotAfter((days * dayToSeconds) + secs);
+const std::string& Certificate::getSubjectNameHash() const
+{
+    return identity.subjectNameHash;
+}
 
-    ASN1_TIME* notBefore = X509_get_notBefore(cert.get());
-    ASN1_TIME_diff(&days, &secs, epoch.get(), notBefore);
-    validNotBefore((days * dayToSeconds) + secs);
+const CertificateIdentity& Certificate::getIdentity() const
+{
+    return identity;
 }
 
-internal::X509Ptr Certificate::loadCert(const std::string& filePath)
+const CertificateMetadata& Certificate::getProperties() const
 {
-    // Read Certificate file
-    internal::X509Ptr cert(X509_new(), ::X509_free);
-    if (!cert)
+    if (!properties)
     {
-        log<level::ERR>("Error occurred during X509_new call",
-                        entry("FILE=%s", filePath.c_str()),
-                        entry("ERRCODE=%lu", ERR_get_error()));
-        elog<InternalFailure>();
+        CertificateContent content = loadCertificate(certFilePath);
+        properties = std::make_unique<CertificateMetadata>(
+            extractMetadata(*content.cert));
     }
+    return *properties;
+}
 
-    BIOMemPtr bioCert(BIO_new_file(filePath.c_str(), "rb"), ::BIO_free);
-    if (!bioCert)
+void Certificate::invalidateProperties()
+{
+    properties.reset();
+    if (!published)
     {
-        log<level::ERR>("Error occurred during BIO_new_file call",
-                        entry("FILE=%s", filePath.c_str()));
-        elog<InternalFailure>();
+        return;
     }
-
-    X509* x509 = cert.get();
-    if (!PEM_read_bio_X509(bioCert.get(), &x509, nullptr, nullptr))
+    propertiesChanged = true;
+    if (!manager.signalsDeferred())
     {
-        log<level::ERR>("Error occurred during PEM_read_bio_X509 call",
-                        entry("FILE=%s", filePath.c_str()));
-        elog<InternalFailure>();
+        flushSignals();
     }
-    return cert;
 }
 
-void Certificate::checkAndAppendPrivateKey(const std::string& filePath)
+void Certificate::flushSignals()
 {
-    BIOMemPtr keyBio(BIO_new(BIO_s_file()), ::BIO_free);
-    if (!keyBio)
+    if (!published)
     {
-        log<level::ERR>("Error occurred during BIO_s_file call",
-                        entry("FILE=%s", filePath.c_str()));
-        elog<InternalFailure>();
+        emitObjectAdded();
+        published = true;
+        propertiesChanged = false;
     }
-    BIO_read_filename(keyBio.get(), filePath.c_str());
-
-    EVPPkeyPtr priKey(
-        PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr),
-        ::EVP_PKEY_free);
-    if (!priKey)
+    else if (propertiesChanged)
     {
-        log<level::INFO>("Private key not present in file",
-                         entry("FILE=%s", filePath.c_str()));
-        fs::path privateKeyFile = fs::path(certInstallPath).parent_path();
-        privateKeyFile = privateKeyFile / defaultPrivateKeyFileName;
-        if (!fs::exists(privateKeyFile))
-        {
-            log<level::ERR>("Private key file is not found",
-                            entry("FILE=%s", privateKeyFile.c_str()));
-            elog<InternalFailure>();
-        }
-
-        std::ifstream privKeyFileStream;
-        std::ofstream certFileStream;
-        privKeyFileStream.exceptions(std::ifstream::failbit |
-                                     std::ifstream::badbit |
-                                     std::ifstream::eofbit);
-        certFileStream.exceptions(std::ofstream::failbit |
-                                  std::ofstream::badbit |
-                                  std::ofstream::eofbit);
-        try
-        {
-            privKeyFileStream.open(privateKeyFile);
-            certFileStream.open(filePath, std::ios::app);
-            certFileStream << std::endl; // insert line break
-            certFileStream << privKeyFileStream.rdbuf() << std::flush;
-            privKeyFileStream.close();
-            certFileStream.close();
-        }
-        catch (const std::exception& e)
-        {
-            log<level::ERR>("Failed to append private key",
-                            entry("ERR=%s", e.what()),
-                            entry("SRC=%s", privateKeyFile.c_str()),
-                            entry("DST=%s", filePath.c_str()));
-            elog<InternalFailure>();
-        }
+        emitPropertiesChanged();
+        propertiesChanged = false;
     }
 }
 
-bool Certificate::compareKeys(const std::string& filePath)
+void Certificate::emitObjectAdded()
 {
-    log<level::INFO>("Certificate compareKeys",
-                     entry("FILEPATH=%s", filePath.c_str()));
-    internal::X509Ptr cert(X509_new(), ::X509_free);
-    if (!cert)
+    // sd_bus_emit_object_added() would read every property, the file is
+    // left alone and the interfaces are announced without them.
+    const std::string managerPath = fs::path(objectPath).parent_path();
+    sd_bus_message* m = nullptr;
+    int r = sd_bus_message_new_signal(bus.get(), &m, managerPath.c_str(),
+                                      "org.freedesktop.DBus.ObjectManager",
+                                      "InterfacesAdded");
+    BusMessagePtr msg(m, ::sd_bus_message_unref);
+    if (r >= 0)
     {
-        log<level::ERR>("Error occurred during X509_new call",
-                        entry("FILE=%s", filePath.c_str()),
-                        entry("ERRCODE=%lu", ERR_get_error()));
-        elog<InternalFailure>();
+        r = sd_bus_message_append(m, "o", objectPath.c_str());
     }
-
-    BIOMemPtr bioCert(BIO_new_file(filePath.c_str(), "rb"), ::BIO_free);
-    if (!bioCert)
+    if (r >= 0)
     {
-        log<level::ERR>("Error occurred during BIO_new_file call",
-                        entry("FILE=%s", filePath.c_str()));
-        elog<InternalFailure>();
+        r = sd_bus_message_open_container(m, 'a', "{sa{sv}}");
+    }
+    for (const char* interface : objectInterfaces)
+    {
+        if (r >= 0)
+        {
+            r = sd_bus_message_append(m, "{sa{sv}}", interface, 0);
+        }
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_close_container(m);
     }
+    if (r >= 0)
+    {
+        r = sd_bus_send(bus.get(), m, nullptr);
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to signal the new certificate object",
+                        entry("ERR=%s", std::strerror(-r)),
+                        entry("PATH=%s", objectPath.c_str()));
+    }
+}
 
-    X509* x509 = cert.get();
-    PEM_read_bio_X509(bioCert.get(), &x509, nullptr, nullptr);
+void Certificate::emitPropertiesChanged()
+{
+    // Only invalidated, the new values are decoded when a client asks
+    int r = emitInvalidated(
+        bus.get(), objectPath.c_str(),
+        sdbusplus::xyz::openbmc_project::Certs::server::Certificate::interface,
+        {"CertificateString", "KeyUsage", "Issuer", "Subject", "ValidNotAfter",
+         "ValidNotBefore"});
+    if (r >= 0)
+    {
+        r = emitInvalidated(bus.get(), objectPath.c_str(), detailsInterface,
+                            {"SerialNumber", "FingerprintSHA256",
+                             "FingerprintSHA1", "SubjectAlternativeNames",
+                             "SubjectKeyIdentifier", "AuthorityKeyIdentifier",
+                             "KeyType", "KeySize", "SignatureAlgorithm"});
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to signal certificate property change",
+                        entry("ERR=%s", std::strerror(-r)),
+                        entry("PATH=%s", objectPath.c_str()));
+    }
+}
 
-    EVPPkeyPtr pubKey(X509_get_pubkey(cert.get()), ::EVP_PKEY_free);
-    if (!pubKey)
+void Certificate::checkAndAppendPrivateKey(CertificateContent& content)
+{
+    if (content.privateKey)
     {
-        log<level::ERR>("Error occurred during X509_get_pubkey",
-                        entry("FILE=%s", filePath.c_str()),
-                        entry("ERRCODE=%lu", ERR_get_error()));
-        elog<InvalidCertificateError>(
-            InvalidCertificate::REASON("Failed to get public key info"));
+        return;
     }
 
-    BIOMemPtr keyBio(BIO_new(BIO_s_file()), ::BIO_free);
-    if (!keyBio)
+    log<level::INFO>("Private key not present in file",
+                     entry("FILE=%s", content.sourcePath.c_str()));
+    fs::path privateKeyFile = fs::path(certInstallPath).parent_path();
+    privateKeyFile = privateKeyFile / defaultPrivateKeyFileName;
+    if (!fs::exists(privateKeyFile))
     {
-        log<level::ERR>("Error occurred during BIO_s_file call",
-                        entry("FILE=%s", filePath.c_str()));
+        log<level::ERR>("Private key file is not found",
+                        entry("FILE=%s", privateKeyFile.c_str()));
         elog<InternalFailure>();
     }
-    BIO_read_filename(keyBio.get(), filePath.c_str());
 
-    EVPPkeyPtr priKey(
-        PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr),
-        ::EVP_PKEY_free);
-    if (!priKey)
+    std::string key = readFile(privateKeyFile);
+    BIOMemPtr keyBio(BIO_new_mem_buf(key.data(), static_cast<int>(key.size())),
+                     ::BIO_free);
+    if (!keyBio)
     {
-        log<level::ERR>("Error occurred during PEM_read_bio_PrivateKey",
-                        entry("FILE=%s", filePath.c_str()),
-                        entry("ERRCODE=%lu", ERR_get_error()));
-        elog<InvalidCertificateError>(
-            InvalidCertificate::REASON("Failed to get private key info"));
+        log<level::ERR>("Error occurred during BIO_new_mem_buf call",
+                        entry("FILE=%s", privateKeyFile.c_str()));
+        elog<InternalFailure>();
     }
+    content.privateKey.reset(
+        PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr));
 
-#if (OPENSSL_VERSION_NUMBER < 0x30000000L)
-    int32_t rc = EVP_PKEY_cmp(priKey.get(), pubKey.get());
-#else
-    int32_t rc = EVP_PKEY_eq(priKey.get(), pubKey.get());
-#endif
-    if (rc != 1)
-    {
-        log<level::ERR>("Private key is not matching with Certificate",
-                        entry("FILE=%s", filePath.c_str()),
-                        entry("ERRCODE=%d", rc));
-        return false;
-    }
-    return true;
+    // insert line break
+    content.pem += '\n';
+    content.pem += key;
 }
 
 void Certificate::delete_()
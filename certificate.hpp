@@ -1,16 +1,18 @@
 #pragma once
 
+#include "bus_method.hpp"
+#include "cert_metadata.hpp"
 #include "watch.hpp"
+#include "x509_utils.hpp"
 
-#include <openssl/ossl_typ.h>
-#include <openssl/x509.h>
-
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <sdbusplus/server/object.hpp>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 #include <xyz/openbmc_project/Certs/Certificate/server.hpp>
 #include <xyz/openbmc_project/Certs/Replace/server.hpp>
 #include <xyz/openbmc_project/Object/Delete/server.hpp>
@@ -65,9 +67,8 @@ using CertificateInterface = sdbusplus::server::object_t<
     sdbusplus::xyz::openbmc_project::Certs::server::Certificate,
     sdbusplus::xyz::openbmc_project::Certs::server::Replace,
     sdbusplus::xyz::openbmc_project::Object::server::Delete>;
-using InstallFunc = std::function<void(const std::string&)>;
-using AppendPrivKeyFunc = std::function<void(const std::string&)>;
-using X509Ptr = std::unique_ptr<X509, decltype(&::X509_free)>;
+using InstallFunc = std::function<void(const CertificateContent&)>;
+using AppendPrivKeyFunc = std::function<void(CertificateContent&)>;
 } // namespace internal
 
 class Manager; // Forward declaration for Certificate Manager.
@@ -93,30 +94,97 @@ class Certificate : public internal::CertificateInterface
      *  @param[in] objPath - Object path to attach to
      *  @param[in] type - Type of the certificate
      *  @param[in] installPath - Path of the certificate to install
-     *  @param[in] uploadPath - Path of the certificate file to upload
+     *  @param[in] content - Parsed and verified certificate to install
      *  @param[in] watchPtr - watch on self signed certificate
      *  @param[in] parent - the manager that owns the certificate
      */
     Certificate(sdbusplus::bus::bus& bus, const std::string& objPath,
                 CertificateType type, const std::string& installPath,
-                const std::string& uploadPath, Watch* watch, Manager& parent);
+                CertificateContent&& content, Watch* watch, Manager& parent);
 
-    /** @brief Validate and Replace/Install the certificate file
+    /** @brief Constructor for a certificate restored from its cached
+     *  identity, the file is neither parsed nor written.
+     *  @param[in] bus - Bus to attach to.
+     *  @param[in] objPath - Object path to attach to
+     *  @param[in] type - Type of the certificate
+     *  @param[in] installPath - Path of the certificate to install
+     *  @param[in] filePath - Installed certificate file
+     *  @param[in] identity - Identity of the installed certificate
+     *  @param[in] watchPtr - watch on self signed certificate
+     *  @param[in] parent - the manager that owns the certificate
+     */
+    Certificate(sdbusplus::bus::bus& bus, const std::string& objPath,
+                CertificateType type, const std::string& installPath,
+                const std::string& filePath, CertificateIdentity&& identity,
+                Watch* watch, Manager& parent);
+
+    /** @brief Replace/Install the certificate file
      *  Install/Replace the existing certificate file with another
-     *  (possibly CA signed) Certificate file.
-     *  @param[in] filePath - Certificate file path.
+     *  (possibly CA signed) Certificate file. The content is expected to be
+     *  verified already, see validateCertificate().
+     *  @param[in] content - Parsed certificate context.
      */
-    void install(const std::string& filePath);
+    void install(CertificateContent&& content);
 
     /** @brief Validate certificate and replace the existing certificate
      *  @param[in] filePath - Certificate file path.
      */
     void replace(const std::string filePath) override;
 
-    /** @brief Populate certificate properties by parsing certificate file
+    /** @brief Validate already parsed certificate and replace the existing
+     *  certificate, e.g. with data passed over D-Bus.
+     *  @param[in] content - Parsed certificate context.
+     */
+    void replace(CertificateContent&& content);
+
+    /** @brief Replace the existing certificate with a PEM upload, read and
+     *  verified on a worker thread. The call is replied to once it is
+     *  replaced.
+     *  @param[in] call - ReplaceFromFd or ReplaceFromPEM method call.
+     *  @param[in] read - Job returning the uploaded PEM data.
+     */
+    void replaceAsync(sd_bus_message* call,
+                      std::function<std::string()>&& read);
+
+    /** @brief Refresh the certificate after its file changed. The identity
+     *  is read again, the property values are decoded on the next read.
+     *  The owner is responsible for updating any index built on the
+     *  certificate ID and digest.
      */
     void populateProperties();
 
+    /** @brief Refresh the certificate with the identity of its changed file,
+     *  as read by the caller. The index is left to the owner, like
+     *  populateProperties() does.
+     *  @param[in] newIdentity - Identity of the new file content.
+     */
+    void refresh(CertificateIdentity&& newIdentity);
+
+    using internal::CertificateInterface::certificateString;
+    using internal::CertificateInterface::issuer;
+    using internal::CertificateInterface::keyUsage;
+    using internal::CertificateInterface::subject;
+    using internal::CertificateInterface::validNotAfter;
+    using internal::CertificateInterface::validNotBefore;
+
+    /** @brief PEM encoding of the certificate, decoded on demand */
+    std::string certificateString() const override;
+
+    /** @brief Key usages of the certificate, decoded on demand */
+    std::vector<std::string> keyUsage() const override;
+
+    /** @brief Issuer of the certificate, decoded on demand */
+    std::string issuer() const override;
+
+    /** @brief Subject of the certificate, decoded on demand */
+    std::string subject() const override;
+
+    /** @brief End of the validity period, decoded on demand */
+    uint64_t validNotAfter() const override;
+
+    /** @brief Start of the validity period, decoded on demand */
+    uint64_t validNotBefore() const override;
+
     /**
      * @brief Obtain certificate ID.
      *
@@ -125,78 +193,92 @@ class Certificate : public internal::CertificateInterface
     std::string getCertId() const;
 
     /**
-     * @brief Check if provided certificate is the same as the current one.
-     *
-     * @param[in] certPath - File path for certificate to check.
+     * @brief Obtain SHA-256 digest of the installed certificate.
      *
-     * @return Checking result. Return true if certificates are the same,
-     *         false if not.
+     * @return Certificate digest.
      */
-    bool isSame(const std::string& certPath);
+    const std::string& getCertDigest() const;
 
     /**
-     * @brief Update certificate storage.
+     * @brief Obtain installed certificate file path.
+     *
+     * @return Certificate file path.
      */
-    void storageUpdate();
+    const std::string& getCertFilePath() const;
 
     /**
-     * @brief Delete the certificate
+     * @brief Obtain the D-Bus object path of the certificate.
+     *
+     * @return Object path.
      */
-    void delete_() override;
+    const std::string& getObjectPath() const;
 
-  private:
     /**
-     * @brief Return error if ceritificate NotBefore date is lt 1970
-     *
-     * Parse the certificate and return error if certificate NotBefore date
-     * is lt 1970.
-     *
-     * @param[in] cert  Reference to certificate object uploaded
+     * @brief Obtain subject name hash of the installed certificate.
      *
-     * @return void
+     * @return Subject name hash as formatted string.
      */
-    void validateCertificateStartDate(X509& cert);
+    const std::string& getSubjectNameHash() const;
 
     /**
-     * @brief Populate certificate properties by parsing given certificate file
+     * @brief Obtain identity of the installed certificate.
      *
-     * @param[in] certPath   Path to certificate that should be parsed
-     *
-     * @return void
+     * @return Certificate identity.
      */
-    void populateProperties(const std::string& certPath);
+    const CertificateIdentity& getIdentity() const;
 
-    /** @brief Load Certificate file into the X509 structure.
-     *  @param[in] filePath - Certificate and key full file path.
-     *  @return pointer to the X509 structure.
+    /**
+     * @brief Obtain property values of the installed certificate. They are
+     * decoded from the file unless that was done since it last changed.
+     *
+     * @return Property values.
      */
-    internal::X509Ptr loadCert(const std::string& filePath);
+    const CertificateMetadata& getProperties() const;
 
-    /** @brief Check and append private key to the certificate file
-     *         If private key is not present in the certificate file append the
-     *         certificate file with private key existing in the system.
-     *  @param[in] filePath - Certificate and key full file path.
-     *  @return void.
+    /**
+     * @brief Emit the signals held back while the manager defers them:
+     * InterfacesAdded for a new object, PropertiesChanged for an object
+     * whose file changed.
      */
-    void checkAndAppendPrivateKey(const std::string& filePath);
-
-    /** @brief Public/Private key compare function.
-     *         Comparing private key against certificate public key
-     *         from input .pem file.
-     *  @param[in] filePath - Certificate and key full file path.
-     *  @return Return true if Key compare is successful,
-     *          false if not
+    void flushSignals();
+
+    /**
+     * @brief Remove the certificate file, before the object is dropped for
+     * good. The file stays when the object only goes away with the service.
      */
-    bool compareKeys(const std::string& filePath);
+    void removeFile();
 
     /**
-     * @brief Generate certificate ID based on provided certificate file.
-     *
-     * @param[in] certPath - Certificate file path.
-     *
-     * @return Certificate ID as formatted string.
+     * @brief Delete the certificate
+     */
+    void delete_() override;
+
+  private:
+    /** @brief Set up the type specific handlers and the D-Bus methods
+     *  @param[in] bus - Bus to attach to.
+     */
+    void initialize(sdbusplus::bus::bus& bus);
+
+    /** @brief Drop the decoded property values after the file changed and
+     *  let clients of a published object know.
+     */
+    void invalidateProperties();
+
+    /** @brief Emit InterfacesAdded without the property values, which
+     *  would have to be decoded from the file
+     */
+    void emitObjectAdded();
+
+    /** @brief Emit PropertiesChanged invalidating all decoded properties */
+    void emitPropertiesChanged();
+
+    /** @brief Check and append private key to the certificate content
+     *         If private key is not present in the certificate content append
+     *         the private key existing in the system.
+     *  @param[in] content - Parsed certificate context.
+     *  @return void.
      */
-    std::string generateCertId(const std::string& certPath);
+    void checkAndAppendPrivateKey(CertificateContent& content);
 
     /**
      * @brief Generate file name which is unique in the provided directory.
@@ -207,28 +289,6 @@ class Certificate : public internal::CertificateInterface
      */
     std::string generateUniqueFilePath(const std::string& directoryPath);
 
-    /**
-     * @brief Generate authority certificate file path corresponding with
-     * OpenSSL requirements.
-     *
-     * Prepare authority certificate file path for provided certificate.
-     * OpenSSL puts some restrictions on the certificate file name pattern.
-     * Certificate full file name needs to consists of basic file name which
-     * is certificate subject name hash and file name extension which is an
-     * integer. More over, certificates files names extensions must be
-     * consecutive integer numbers in case many certificates with the same
-     * subject name.
-     * https://www.boost.org/doc/libs/1_69_0/doc/html/boost_asio/reference/ssl__context/add_verify_path.html
-     * https://www.openssl.org/docs/man1.0.2/man3/SSL_CTX_load_verify_locations.html
-     *
-     * @param[in] certSrcFilePath - Certificate source file path.
-     * @param[in] certDstDirPath - Certificate destination directory path.
-     *
-     * @return Authority certificate file path.
-     */
-    std::string generateAuthCertFileX509Path(const std::string& certSrcFilePath,
-                                             const std::string& certDstDirPath);
-
     /**
      * @brief Generate authority certificate file path based on provided
      * certificate source file path.
@@ -249,6 +309,9 @@ class Certificate : public internal::CertificateInterface
      */
     std::string generateCertFilePath(const std::string& certSrcFilePath);
 
+    /** @brief sdbusplus handler */
+    sdbusplus::bus::bus& bus;
+
     /** @brief Type specific function pointer map */
     std::unordered_map<CertificateType, internal::InstallFunc> typeFuncMap;
 
@@ -258,14 +321,23 @@ class Certificate : public internal::CertificateInterface
     /** @brief Type of the certificate */
     CertificateType certType;
 
-    /** @brief Stores certificate ID */
-    std::string certId;
+    /** @brief Certificate file installation path */
+    std::string certInstallPath;
 
     /** @brief Stores certificate file path */
     std::string certFilePath;
 
-    /** @brief Certificate file installation path */
-    std::string certInstallPath;
+    /** @brief Stores certificate ID, digest and subject name hash */
+    CertificateIdentity identity;
+
+    /** @brief Property values, decoded on the first read */
+    mutable std::unique_ptr<CertificateMetadata> properties;
+
+    /** @brief Object was announced on D-Bus */
+    bool published = false;
+
+    /** @brief Property change not signalled yet */
+    bool propertiesChanged = false;
 
     /** @brief Type specific function pointer map for appending private key */
     std::unordered_map<CertificateType, internal::AppendPrivKeyFunc>
@@ -278,6 +350,12 @@ class Certificate : public internal::CertificateInterface
 
     /** @brief Reference to Certificate Manager */
     Manager& manager;
+
+    /** @brief Replace from data D-Bus methods registration */
+    BusSlotPtr replaceDataSlot{nullptr, ::sd_bus_slot_unref};
+
+    /** @brief Certificate details D-Bus properties registration */
+    BusSlotPtr detailsSlot{nullptr, ::sd_bus_slot_unref};
 };
 
 } // namespace phosphor::certs
@@ -2,6 +2,9 @@
 
 #include "certs_manager.hpp"
 
+#include "crypto_context.hpp"
+#include "publish.hpp"
+
 #include <openssl/asn1.h>
 #include <openssl/bn.h>
 #include <openssl/ec.h>
@@ -11,17 +14,19 @@
 #include <openssl/opensslv.h>
 #include <openssl/pem.h>
 #include <openssl/rsa.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <array>
 #include <cerrno>
 #include <chrono>
-#include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <exception>
+#include <future>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
@@ -29,7 +34,7 @@
 #include <sdbusplus/exception.hpp>
 #include <sdbusplus/message.hpp>
 #include <sdeventplus/source/base.hpp>
-#include <sdeventplus/source/child.hpp>
+#include <unordered_set>
 #include <utility>
 #include <xyz/openbmc_project/Certs/error.hpp>
 #include <xyz/openbmc_project/Common/error.hpp>
@@ -62,20 +67,242 @@ using X509ReqPtr = std::unique_ptr<X509_REQ, decltype(&::X509_REQ_free)>;
 using EVPPkeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
 using BignumPtr = std::unique_ptr<BIGNUM, decltype(&::BN_free)>;
 
-constexpr int supportedKeyBitLength = 2048;
+// Larger keys take seconds to minutes to generate, they are generated in
+// the background and kept ready in the key pool once requested.
+constexpr std::array<int64_t, 3> supportedKeyBitLengths = {2048, 3072, 4096};
 constexpr int defaultKeyBitLength = 2048;
-// secp224r1 is equal to RSA 2048 KeyBitLength. Refer RFC 5349
-constexpr auto defaultKeyCurveID = "secp224r1";
+// prime256v1 (P-256) is equal to RSA 3072 KeyBitLength. Refer RFC 5349
+constexpr auto defaultKeyCurveID = "prime256v1";
+constexpr auto defaultEdDSACurveID = "Ed25519";
+
+// CSRs are generated one after the other by a dedicated thread, further
+// requests are rejected while this many are waiting or running.
+constexpr size_t maxPendingCSRs = 4;
+
+constexpr auto bundleInterface = "xyz.openbmc_project.Certs.InstallBundle";
+constexpr auto bundleInstalled = "Installed";
+constexpr auto bundleDuplicate = "Duplicate";
+constexpr auto installDataInterface = "xyz.openbmc_project.Certs.InstallData";
+constexpr auto reloadInterface = "xyz.openbmc_project.Certs.Reload";
+constexpr auto reloadStatusRunning = "Running";
+constexpr auto reloadStatusSucceeded = "Succeeded";
+constexpr auto reloadStatusFailed = "Failed";
+
+// systemd may be busy restarting other units, do not give up too early.
+constexpr std::chrono::microseconds reloadTimeout = std::chrono::seconds(30);
+
+int replyBundleResults(sd_bus_message* call,
+                       const std::vector<BundleResult>& results)
+{
+    sd_bus_message* replyRaw = nullptr;
+    int r = sd_bus_message_new_method_return(call, &replyRaw);
+    if (r < 0)
+    {
+        return r;
+    }
+    BusMessagePtr reply(replyRaw, ::sd_bus_message_unref);
+    r = sd_bus_message_open_container(reply.get(), 'a', "(so)");
+    for (const auto& [status, path] : results)
+    {
+        if (r < 0)
+        {
+            break;
+        }
+        r = sd_bus_message_append(reply.get(), "(so)", status.c_str(),
+                                  path.empty() ? "/" : path.c_str());
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_close_container(reply.get());
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_send(nullptr, reply.get(), nullptr);
+    }
+    return r;
+}
+
+// OpenSSL store of the trust anchors, null if the uploaded data is trusted.
+X509_STORE* storeOf(const std::shared_ptr<TrustStore>& anchors)
+{
+    return anchors ? anchors->get() : nullptr;
+}
+
+// Verify every bundle entry, either in parallel on the pool or in turn on
+// the calling thread if there is none. One invalid entry rejects the bundle.
+void validateBundle(const std::vector<CertificateContent>& entries,
+                    const std::string& filePath, X509_STORE* anchors,
+                    WorkerPool* pool)
+{
+    std::vector<std::future<void>> checks;
+    if (pool)
+    {
+        checks.reserve(entries.size());
+        for (const auto& content : entries)
+        {
+            checks.emplace_back(pool->submit([&content, anchors]() {
+                validateCertificate(content, anchors);
+            }));
+        }
+    }
+
+    bool valid = true;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        try
+        {
+            if (pool)
+            {
+                checks[i].get();
+            }
+            else
+            {
+                validateCertificate(entries[i], anchors);
+            }
+        }
+        catch (const InvalidCertificate& e)
+        {
+            log<level::ERR>("Invalid certificate in bundle",
+                            entry("FILE=%s", filePath.c_str()),
+                            entry("ENTRY=%zu", i));
+            valid = false;
+        }
+    }
+    if (!valid)
+    {
+        elog<InvalidCertificate>(
+            InvalidCertificateReason("Bundle contains invalid certificates"));
+    }
+}
+
+// The data methods below reply once the worker threads are done with the
+// upload, the event loop keeps serving other requests meanwhile.
+
+int installBundleHandler(sd_bus_message* msg, void* userdata,
+                         sd_bus_error* error)
+{
+    return handleBusMethod(error, [msg, userdata]() {
+        const char* filePath = nullptr;
+        int r = sd_bus_message_read(msg, "s", &filePath);
+        if (r < 0)
+        {
+            return r;
+        }
+        static_cast<Manager*>(userdata)->installBundleAsync(msg, filePath);
+        return 1;
+    });
+}
+
+int installFdHandler(sd_bus_message* msg, void* userdata, sd_bus_error* error)
+{
+    return handleBusMethod(error, [msg, userdata]() {
+        int fd = -1;
+        int r = sd_bus_message_read(msg, "h", &fd);
+        if (r < 0)
+        {
+            return r;
+        }
+        static_cast<Manager*>(userdata)->installAsync(
+            msg, fileDescriptorReader(fd));
+        return 1;
+    });
+}
+
+int installPEMHandler(sd_bus_message* msg, void* userdata, sd_bus_error* error)
+{
+    return handleBusMethod(error, [msg, userdata]() {
+        const char* pem = nullptr;
+        int r = sd_bus_message_read(msg, "s", &pem);
+        if (r < 0)
+        {
+            return r;
+        }
+        static_cast<Manager*>(userdata)->installAsync(
+            msg, [data = std::string(pem)]() { return data; });
+        return 1;
+    });
+}
+
+int reloadPendingGetter(sd_bus*, const char*, const char*, const char*,
+                        sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    int pending = static_cast<Manager*>(userdata)->isReloadPending();
+    return sd_bus_message_append(reply, "b", pending);
+}
+
+int reloadStatusGetter(sd_bus*, const char*, const char*, const char*,
+                       sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    return sd_bus_message_append(
+        reply, "s",
+        static_cast<Manager*>(userdata)->getReloadStatus().c_str());
+}
+
+const sd_bus_vtable reloadVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_PROPERTY("ReloadPending", "b", reloadPendingGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+    SD_BUS_PROPERTY("ReloadStatus", "s", reloadStatusGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+    SD_BUS_VTABLE_END};
+
+const sd_bus_vtable installDataVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("InstallFromFd", "h", "o", installFdHandler,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_METHOD("InstallFromPEM", "s", "o", installPEMHandler,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_VTABLE_END};
+
+const sd_bus_vtable bundleVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("InstallBundle", "s", "a(so)", installBundleHandler,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_VTABLE_END};
 } // namespace
 
 Manager::Manager(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
                  const char* path, CertificateType type,
-                 const std::string& unit, const std::string& installPath) :
+                 const std::string& unit, const std::string& installPath,
+                 bool deferRestore) :
     internal::ManagerInterface(bus, path),
     bus(bus), event(event), objectPath(path), certType(type),
     unitToRestart(std::move(unit)), certInstallPath(std::move(installPath)),
-    certParentInstallPath(fs::path(certInstallPath).parent_path())
+    reloadScheduler(std::make_unique<ReloadScheduler>(
+        event, [this](const std::string& name) { reloadOrReset(name); },
+        std::chrono::milliseconds(reloadQuietWindowMs),
+        std::chrono::milliseconds(reloadMaxDelayMs), [this]() {
+            sd_bus_emit_properties_changed(this->bus.get(), objectPath.c_str(),
+                                           reloadInterface, "ReloadPending",
+                                           nullptr);
+        })),
+    loopQueue(std::make_unique<LoopQueue>(event)),
+    workerPool(std::make_unique<WorkerPool>(workerThreads)),
+    certParentInstallPath(fs::path(certInstallPath).parent_path()),
+    csrWorker(std::make_unique<WorkerPool>(1))
 {
+    sd_bus_slot* slot = nullptr;
+    int r = sd_bus_add_object_vtable(bus.get(), &slot, objectPath.c_str(),
+                                     reloadInterface, reloadVtable, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to register reload state property",
+                        entry("ERR=%s", std::strerror(-r)),
+                        entry("PATH=%s", objectPath.c_str()));
+    }
+    reloadSlot.reset(slot);
+
+    slot = nullptr;
+    r = sd_bus_add_object_vtable(bus.get(), &slot, objectPath.c_str(),
+                                 installDataInterface, installDataVtable, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to register install from data methods",
+                        entry("ERR=%s", std::strerror(-r)),
+                        entry("PATH=%s", objectPath.c_str()));
+    }
+    installDataSlot.reset(slot);
+
     try
     {
         // Create certificate directory if not existing.
@@ -101,6 +328,11 @@ Manager::Manager(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
                               fs::perms::owner_exec;
             fs::permissions(certDirectory, permission,
                             fs::perm_options::replace);
+            if (certType == CertificateType::Authority)
+            {
+                authorityLinks =
+                    std::make_unique<AuthorityLinks>(certInstallPath);
+            }
             storageUpdate();
         }
         catch (const fs::filesystem_error& e)
@@ -111,73 +343,54 @@ Manager::Manager(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
             report<InternalFailure>();
         }
 
+        // Metadata of unchanged certificate files is restored from here
+        if (certType == CertificateType::Authority)
+        {
+            metadataCache = std::make_unique<MetadataCache>(
+                (fs::path(certInstallPath) / ".metadata").string());
+        }
+        else
+        {
+            metadataCache = std::make_unique<MetadataCache>(
+                (certParentInstallPath /
+                 ("." + fs::path(certInstallPath).filename().string() +
+                  ".metadata"))
+                    .string());
+        }
+
         // Generating RSA private key file if certificate type is server/client
         if (certType != CertificateType::Authority)
         {
+            keyPool = std::make_unique<KeyPool>(
+                certParentInstallPath / defaultKeyPoolDirName, keyPoolDepth,
+                [this](const KeySpec& spec) { return generateKeyPair(spec); });
             createRSAPrivateKeyFile();
         }
 
-        // restore any existing certificates
-        createCertificates();
+        if (certType == CertificateType::Authority)
+        {
+            slot = nullptr;
+            r = sd_bus_add_object_vtable(bus.get(), &slot, objectPath.c_str(),
+                                         bundleInterface, bundleVtable, this);
+            if (r < 0)
+            {
+                log<level::ERR>("Failed to register bundle install method",
+                                entry("ERR=%s", std::strerror(-r)),
+                                entry("PATH=%s", objectPath.c_str()));
+            }
+            bundleSlot.reset(slot);
+        }
 
-        // watch is not required for authority certificates
-        if (certType != CertificateType::Authority)
+        // restore any existing certificates
+        if (deferRestore)
         {
-            // watch for certificate file create/replace
-            certWatchPtr = std::make_unique<
-                Watch>(event, certInstallPath, [this]() {
-                try
-                {
-                    // if certificate file existing update it
-                    if (!installedCerts.empty())
-                    {
-                        log<level::INFO>("Inotify callback to update "
-                                         "certificate properties");
-                        installedCerts[0]->populateProperties();
-                    }
-                    else
-                    {
-                        log<level::INFO>(
-                            "Inotify callback to create certificate object");
-                        createCertificates();
-                    }
-                }
-                catch (const InternalFailure& e)
-                {
-                    commit<InternalFailure>();
-                }
-                catch (const InvalidCertificate& e)
-                {
-                    commit<InvalidCertificate>();
-                }
-            });
+            restoring = true;
         }
         else
         {
-            try
-            {
-                const std::string singleCertPath = "/etc/ssl/certs/Root-CA.pem";
-                if (fs::exists(singleCertPath) && !fs::is_empty(singleCertPath))
-                {
-                    log<level::NOTICE>(
-                        "Legacy certificate detected, will be installed from: ",
-                        entry("SINGLE_CERTPATH=%s", singleCertPath.c_str()));
-                    install(singleCertPath);
-                    if (!fs::remove(singleCertPath))
-                    {
-                        log<level::ERR>(
-                            "Unable to remove old certificate from: ",
-                            entry("SINGLE_CERTPATH=%s",
-                                  singleCertPath.c_str()));
-                        elog<InternalFailure>();
-                    }
-                }
-            }
-            catch (const std::exception& ex)
-            {
-                log<level::ERR>("Error in restoring legacy certificate",
-                                entry("ERROR_STR=%s", ex.what()));
-            }
+            watchCertificates();
+            createCertificates();
+            completeRestore();
         }
     }
     catch (const std::exception& ex)
@@ -187,36 +400,213 @@ Manager::Manager(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
     }
 }
 
+Manager::~Manager()
+{
+    // Reloads still in their quiet window are made right away. An
+    // asynchronous call would be cancelled with its slot.
+    stopping = true;
+    reloadScheduler->flush();
+}
+
 std::string Manager::install(const std::string filePath)
 {
-    if (certType != CertificateType::Authority && !installedCerts.empty())
+    // Read and parse the upload once, every later stage works from memory.
+    return install(loadCertificate(filePath));
+}
+
+std::string Manager::install(CertificateContent&& content)
+{
+    checkRestored();
+    checkCapacity(1);
+    if (isCertificateUnique(*content.cert))
+    {
+        validateUpload(content);
+    }
+    return addCertificate(std::move(content));
+}
+
+void Manager::installAsync(sd_bus_message* call,
+                           std::function<std::string()>&& read)
+{
+    checkRestored();
+    checkCapacity(1);
+    installTask(holdBusMethod(call), uploadCheck(std::move(read)));
+}
+
+Task Manager::installTask(BusCallPtr call,
+                          std::function<CertificateContent()> check)
+{
+    auto result = co_await onWorker(std::move(check));
+    completeBusMethod(call.get(), [&]() {
+        std::string certObjectPath = addCertificate(result.get());
+        return sd_bus_reply_method_return(call.get(), "o",
+                                          certObjectPath.c_str());
+    });
+}
+
+void Manager::checkCapacity(size_t count) const
+{
+    if (certType != CertificateType::Authority &&
+        installedCerts.size() + count > 1)
     {
         elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
     }
     else if (certType == CertificateType::Authority &&
-             installedCerts.size() >= maxNumAuthorityCertificates)
+             installedCerts.size() + count > maxNumAuthorityCertificates)
     {
         elog<NotAllowed>(NotAllowedReason("Certificates limit reached"));
     }
+}
 
-    std::string certObjectPath;
-    if (isCertificateUnique(filePath))
-    {
-        certObjectPath = objectPath + '/' + std::to_string(certIdCounter);
-        installedCerts.emplace_back(std::make_unique<Certificate>(
-            bus, certObjectPath, certType, certInstallPath, filePath,
-            certWatchPtr.get(), *this));
-        reloadOrReset(unitToRestart);
-        certIdCounter++;
-    }
-    else
+std::string Manager::addCertificate(CertificateContent&& content)
+{
+    // Checked again, the state may have changed while the upload was being
+    // verified on a worker thread.
+    checkCapacity(1);
+    if (!isCertificateUnique(*content.cert))
     {
         elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
     }
 
+    // A failed install must not leave its object path to the next one
+    std::string certObjectPath =
+        objectPath + '/' + std::to_string(certIdCounter++);
+
+    // The object is only announced once it is linked, it is dropped again
+    // if that fails.
+    SignalBatch batch(*this);
+    installedCerts.emplace_back(std::make_unique<Certificate>(
+        bus, certObjectPath, certType, certInstallPath, std::move(content),
+        certWatchPtr.get(), *this));
+    indexCertificate(installedCerts.back().get());
+    if (authorityLinks)
+    {
+        try
+        {
+            authorityLinks->add(installedCerts.back()->getCertFilePath(),
+                                installedCerts.back()->getSubjectNameHash());
+        }
+        catch (...)
+        {
+            unindexCertificate(installedCerts.back().get());
+            installedCerts.back()->removeFile();
+            installedCerts.pop_back();
+            throw;
+        }
+    }
+    recordMetadata(*installedCerts.back());
+    requestReload();
     return certObjectPath;
 }
 
+std::vector<BundleResult> Manager::installBundle(const std::string& filePath)
+{
+    if (certType != CertificateType::Authority)
+    {
+        elog<NotAllowed>(NotAllowedReason(
+            "Bundle install is supported for authority certificates only"));
+    }
+    checkRestored();
+
+    // Read and parse the bundle once, then verify every entry in parallel.
+    std::vector<CertificateContent> entries =
+        splitBundle(loadCertificate(filePath));
+    auto anchors = getTrustAnchors();
+    validateBundle(entries, filePath, storeOf(anchors), workerPool.get());
+    return addBundle(std::move(entries));
+}
+
+void Manager::installBundleAsync(sd_bus_message* call,
+                                 const std::string& filePath)
+{
+    if (certType != CertificateType::Authority)
+    {
+        elog<NotAllowed>(NotAllowedReason(
+            "Bundle install is supported for authority certificates only"));
+    }
+    checkRestored();
+    installBundleTask(holdBusMethod(call), filePath, getTrustAnchors());
+}
+
+Task Manager::installBundleTask(BusCallPtr call, std::string filePath,
+                                std::shared_ptr<TrustStore> anchors)
+{
+    // The whole bundle is checked by one worker, waiting on further jobs
+    // from inside a worker could starve a small pool.
+    auto result = co_await onWorker([&filePath, &anchors]() {
+        std::vector<CertificateContent> entries =
+            splitBundle(loadCertificate(filePath));
+        validateBundle(entries, filePath, storeOf(anchors), nullptr);
+        return entries;
+    });
+    completeBusMethod(call.get(), [&]() {
+        return replyBundleResults(call.get(), addBundle(result.get()));
+    });
+}
+
+std::vector<BundleResult>
+    Manager::addBundle(std::vector<CertificateContent>&& entries)
+{
+    std::vector<BundleResult> results(entries.size());
+    std::vector<size_t> pending;
+    std::unordered_set<std::string> bundleDigests;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (!isCertificateUnique(*entries[i].cert) ||
+            !bundleDigests.insert(generateCertDigest(*entries[i].cert)).second)
+        {
+            results[i].first = bundleDuplicate;
+            continue;
+        }
+        pending.push_back(i);
+    }
+    checkCapacity(pending.size());
+
+    // Either all new certificates are installed or none of them. They are
+    // only announced once the whole bundle is in place.
+    SignalBatch batch(*this);
+    const size_t installedCount = installedCerts.size();
+    const uint64_t firstCertId = certIdCounter;
+    try
+    {
+        for (size_t i : pending)
+        {
+            auto certObjectPath =
+                objectPath + '/' + std::to_string(certIdCounter);
+            installedCerts.emplace_back(std::make_unique<Certificate>(
+                bus, certObjectPath, certType, certInstallPath,
+                std::move(entries[i]), certWatchPtr.get(), *this));
+            certIdCounter++;
+            indexCertificate(installedCerts.back().get());
+            authorityLinks->add(installedCerts.back()->getCertFilePath(),
+                                installedCerts.back()->getSubjectNameHash());
+            results[i] = {bundleInstalled, std::move(certObjectPath)};
+        }
+    }
+    catch (...)
+    {
+        while (installedCerts.size() > installedCount)
+        {
+            unindexCertificate(installedCerts.back().get());
+            authorityLinks->remove(installedCerts.back()->getCertFilePath());
+            installedCerts.back()->removeFile();
+            installedCerts.pop_back();
+        }
+        certIdCounter = firstCertId;
+        throw;
+    }
+
+    if (!pending.empty())
+    {
+        for (size_t i = installedCount; i < installedCerts.size(); ++i)
+        {
+            recordMetadata(*installedCerts[i]);
+        }
+        requestReload();
+    }
+    return results;
+}
+
 void Manager::deleteAll()
 {
     // TODO: #Issue 4 when a certificate is deleted system auto generates
@@ -224,9 +614,20 @@ void Manager::deleteAll()
     // certificate object for the auto-generated certificate file as
     // deletion if only applicable for REST server and Bmcweb does not allow
     // deletion of certificates
+    checkRestored();
+    certIdIndex.clear();
+    certDigestIndex.clear();
+    if (authorityLinks)
+    {
+        authorityLinks->clear();
+    }
+    for (const auto& cert : installedCerts)
+    {
+        cert->removeFile();
+    }
     installedCerts.clear();
-    storageUpdate();
-    reloadOrReset(unitToRestart);
+    metadataCache->clear();
+    requestReload();
 }
 
 void Manager::deleteCertificate(const Certificate* const certificate)
@@ -238,9 +639,16 @@ void Manager::deleteCertificate(const Certificate* const certificate)
                      });
     if (certIt != installedCerts.end())
     {
+        unindexCertificate(certificate);
+        if (authorityLinks)
+        {
+            authorityLinks->remove(certificate->getCertFilePath());
+        }
+        metadataCache->remove(
+            fs::path(certificate->getCertFilePath()).filename());
+        (*certIt)->removeFile();
         installedCerts.erase(certIt);
-        storageUpdate();
-        reloadOrReset(unitToRestart);
+        requestReload();
     }
     else
     {
@@ -253,119 +661,83 @@ void Manager::deleteCertificate(const Certificate* const certificate)
 void Manager::replaceCertificate(Certificate* const certificate,
                                  const std::string& filePath)
 {
-    if (isCertificateUnique(filePath, certificate))
+    replaceCertificate(certificate, loadCertificate(filePath));
+}
+
+void Manager::replaceCertificate(Certificate* const certificate,
+                                 CertificateContent&& content)
+{
+    if (isCertificateUnique(*content.cert, certificate))
     {
-        certificate->install(filePath);
-        storageUpdate();
-        reloadOrReset(unitToRestart);
+        validateUpload(content);
     }
-    else
+    updateCertificate(certificate, std::move(content));
+}
+
+void Manager::replaceCertificateAsync(Certificate* const certificate,
+                                      sd_bus_message* call,
+                                      std::function<std::string()>&& read)
+{
+    // The certificate may be deleted before the upload is verified, it is
+    // looked up again by its object path.
+    replaceTask(holdBusMethod(call), certificate->getObjectPath(),
+                uploadCheck(std::move(read)));
+}
+
+Task Manager::replaceTask(BusCallPtr call, std::string path,
+                          std::function<CertificateContent()> check)
+{
+    auto result = co_await onWorker(std::move(check));
+    completeBusMethod(call.get(), [&]() {
+        CertificateContent content = result.get();
+        Certificate* current = findCertificate(path);
+        if (!current)
+        {
+            elog<NotAllowed>(NotAllowedReason("Certificate no longer exists"));
+        }
+        updateCertificate(current, std::move(content));
+        return sd_bus_reply_method_return(call.get(), "");
+    });
+}
+
+void Manager::updateCertificate(Certificate* const certificate,
+                                CertificateContent&& content)
+{
+    if (!isCertificateUnique(*content.cert, certificate))
     {
         elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
     }
-}
 
-std::string Manager::generateCSR(
-    std::vector<std::string> alternativeNames, std::string challengePassword,
-    std::string city, std::string commonName, std::string contactPerson,
-    std::string country, std::string email, std::string givenName,
-    std::string initials, int64_t keyBitLength, std::string keyCurveId,
-    std::string keyPairAlgorithm, std::vector<std::string> keyUsage,
-    std::string organization, std::string organizationalUnit, std::string state,
-    std::string surname, std::string unstructuredName)
-{
-    // We support only one CSR.
-    csrPtr.reset(nullptr);
-    auto pid = fork();
-    if (pid == -1)
+    unindexCertificate(certificate);
+    try
     {
-        log<level::ERR>("Error occurred during forking process");
-        report<InternalFailure>();
+        certificate->install(std::move(content));
     }
-    else if (pid == 0)
+    catch (...)
     {
-        try
-        {
-            generateCSRHelper(alternativeNames, challengePassword, city,
-                              commonName, contactPerson, country, email,
-                              givenName, initials, keyBitLength, keyCurveId,
-                              keyPairAlgorithm, keyUsage, organization,
-                              organizationalUnit, state, surname,
-                              unstructuredName);
-            exit(EXIT_SUCCESS);
-        }
-        catch (const InternalFailure& e)
-        {
-            // commit the error reported in child process and exit
-            // Callback method from SDEvent Loop looks for exit status
-            exit(EXIT_FAILURE);
-            commit<InternalFailure>();
-        }
-        catch (const InvalidArgument& e)
-        {
-            // commit the error reported in child process and exit
-            // Callback method from SDEvent Loop looks for exit status
-            exit(EXIT_FAILURE);
-            commit<InvalidArgument>();
-        }
+        indexCertificate(certificate);
+        throw;
     }
-    else
+    indexCertificate(certificate);
+    if (authorityLinks)
     {
-        using namespace sdeventplus::source;
-        Child::Callback callback = [this](Child& eventSource,
-                                          const siginfo_t* si) {
-            eventSource.set_enabled(Enabled::On);
-            if (si->si_status != 0)
-            {
-                this->createCSRObject(Status::FAILURE);
-            }
-            else
-            {
-                this->createCSRObject(Status::SUCCESS);
-            }
-        };
-        try
-        {
-            sigset_t ss;
-            if (sigemptyset(&ss) < 0)
-            {
-                log<level::ERR>("Unable to initialize signal set");
-                elog<InternalFailure>();
-            }
-            if (sigaddset(&ss, SIGCHLD) < 0)
-            {
-                log<level::ERR>("Unable to add signal to signal set");
-                elog<InternalFailure>();
-            }
-
-            // Block SIGCHLD first, so that the event loop can handle it
-            if (sigprocmask(SIG_BLOCK, &ss, nullptr) < 0)
-            {
-                log<level::ERR>("Unable to block signal");
-                elog<InternalFailure>();
-            }
-            if (childPtr)
-            {
-                childPtr.reset();
-            }
-            childPtr = std::make_unique<Child>(event, pid, WEXITED | WSTOPPED,
-                                               std::move(callback));
-        }
-        catch (const InternalFailure& e)
-        {
-            commit<InternalFailure>();
-        }
+        authorityLinks->update(certificate->getCertFilePath(),
+                               certificate->getSubjectNameHash());
     }
-    auto csrObjectPath = objectPath + '/' + "csr";
-    return csrObjectPath;
+    recordMetadata(*certificate);
+    requestReload();
 }
 
-std::vector<std::unique_ptr<Certificate>>& Manager::getCertificates()
+Certificate* Manager::findCertificate(const std::string& path) const
 {
-    return installedCerts;
+    auto it = std::find_if(installedCerts.begin(), installedCerts.end(),
+                           [&path](const auto& certificate) {
+                               return certificate->getObjectPath() == path;
+                           });
+    return it == installedCerts.end() ? nullptr : it->get();
 }
 
-void Manager::generateCSRHelper(
+std::string Manager::generateCSR(
     std::vector<std::string> alternativeNames, std::string challengePassword,
     std::string city, std::string commonName, std::string contactPerson,
     std::string country, std::string email, std::string givenName,
@@ -374,26 +746,125 @@ void Manager::generateCSRHelper(
     std::string organization, std::string organizationalUnit, std::string state,
     std::string surname, std::string unstructuredName)
 {
-    int ret = 0;
+    // Invalid parameters are an error of the call, not of the CSR object
+    const KeySpec keySpec =
+        csrKeySpec(keyBitLength, keyCurveId, keyPairAlgorithm);
 
-    // set version of x509 req
-    int nVersion = 1;
-    // TODO: Issue#6 need to make version number configurable
-    X509ReqPtr x509Req(X509_REQ_new(), ::X509_REQ_free);
-    ret = X509_REQ_set_version(x509Req.get(), nVersion);
-    if (ret == 0)
+    if (pendingCSRs >= maxPendingCSRs)
     {
-        log<level::ERR>("Error occurred during X509_REQ_set_version call");
-        elog<InternalFailure>();
+        log<level::ERR>("Too many CSR requests in progress",
+                        entry("PENDING=%zu", pendingCSRs));
+        elog<NotAllowed>(
+            NotAllowedReason("Too many CSR requests in progress"));
     }
 
-    // set subject of x509 req
-    X509_NAME* x509Name = X509_REQ_get_subject_name(x509Req.get());
-
-    if (!alternativeNames.empty())
-    {
-        for (auto& name : alternativeNames)
-        {
+    // We support only one CSR. The object reports the progress right away
+    // and is announced once the CSR is generated.
+    auto csrObjectPath = objectPath + '/' + "csr";
+    csrPtr.reset(nullptr);
+    csrPtr = std::make_unique<CSR>(bus, csrObjectPath.c_str(),
+                                   certInstallPath.c_str(),
+                                   Status::IN_PROGRESS);
+    const uint64_t request = ++csrRequest;
+    ProgressFunc progress = [this, request](uint8_t percent) {
+        loopQueue->post([this, request, percent]() {
+            if (request == csrRequest && csrPtr)
+            {
+                csrPtr->setProgress(percent);
+            }
+        });
+    };
+
+    pendingCSRs++;
+    csrTask(request, [=, this]() {
+        generateCSRHelper(alternativeNames, challengePassword, city,
+                          commonName, contactPerson, country, email,
+                          givenName, initials, keySpec, keyPairAlgorithm,
+                          keyUsage, organization,
+                          organizationalUnit, state, surname, unstructuredName,
+                          progress);
+    });
+    return csrObjectPath;
+}
+
+Task Manager::csrTask(uint64_t request, std::function<void()> job)
+{
+    auto result =
+        co_await WorkerAwaiter(*csrWorker, *loopQueue, std::move(job));
+    pendingCSRs--;
+    Status status = Status::FAILURE;
+    try
+    {
+        result.get();
+        status = Status::SUCCESS;
+    }
+    catch (const InternalFailure& e)
+    {
+        commit<InternalFailure>();
+    }
+    catch (const InvalidArgument& e)
+    {
+        commit<InvalidArgument>();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to generate CSR", entry("ERR=%s", e.what()));
+    }
+    if (request == csrRequest && csrPtr)
+    {
+        csrPtr->setStatus(status);
+    }
+}
+
+bool Manager::isReloadPending() const
+{
+    return reloadScheduler->pending(unitToRestart);
+}
+
+const std::string& Manager::getReloadStatus() const
+{
+    return reloadStatus;
+}
+
+std::vector<std::unique_ptr<Certificate>>& Manager::getCertificates()
+{
+    return installedCerts;
+}
+
+const CSR* Manager::getCSR() const
+{
+    return csrPtr.get();
+}
+
+void Manager::generateCSRHelper(
+    std::vector<std::string> alternativeNames, std::string challengePassword,
+    std::string city, std::string commonName, std::string contactPerson,
+    std::string country, std::string email, std::string givenName,
+    std::string initials, const KeySpec& keySpec, std::string keyPairAlgorithm,
+    std::vector<std::string> keyUsage, std::string organization,
+    std::string organizationalUnit, std::string state, std::string surname,
+    std::string unstructuredName, const ProgressFunc& progress)
+{
+    int ret = 0;
+
+    // set version of x509 req
+    int nVersion = 1;
+    // TODO: Issue#6 need to make version number configurable
+    X509ReqPtr x509Req(X509_REQ_new(), ::X509_REQ_free);
+    ret = X509_REQ_set_version(x509Req.get(), nVersion);
+    if (ret == 0)
+    {
+        log<level::ERR>("Error occurred during X509_REQ_set_version call");
+        elog<InternalFailure>();
+    }
+
+    // set subject of x509 req
+    X509_NAME* x509Name = X509_REQ_get_subject_name(x509Req.get());
+
+    if (!alternativeNames.empty())
+    {
+        for (auto& name : alternativeNames)
+        {
             addEntry(x509Name, "subjectAltName", name);
         }
     }
@@ -431,19 +902,9 @@ void Manager::generateCSRHelper(
     log<level::INFO>("Given Key pair algorithm",
                      entry("KEYPAIRALGORITHM=%s", keyPairAlgorithm.c_str()));
 
-    // Used EC algorithm as default if user did not give algorithm type.
-    if (keyPairAlgorithm == "RSA")
-        pKey = getRSAKeyPair(keyBitLength);
-    else if ((keyPairAlgorithm == "EC") || (keyPairAlgorithm.empty()))
-        pKey = generateECKeyPair(keyCurveId);
-    else
-    {
-        log<level::ERR>("Given Key pair algorithm is not supported. Supporting "
-                        "RSA and EC only");
-        elog<InvalidArgument>(
-            Argument::ARGUMENT_NAME("KEYPAIRALGORITHM"),
-            Argument::ARGUMENT_VALUE(keyPairAlgorithm.c_str()));
-    }
+    // Only the RSA key generation takes long enough to report progress
+    pKey = pooledKeyPair(keySpec,
+                         keySpec.algorithm == "RSA" ? progress : nullptr);
 
     ret = X509_REQ_set_pubkey(x509Req.get(), pKey.get());
     if (ret == 0)
@@ -455,8 +916,15 @@ void Manager::generateCSRHelper(
     // Write private key to file
     writePrivateKey(pKey, defaultPrivateKeyFileName);
 
-    // set sign key of x509 req
-    ret = X509_REQ_sign(x509Req.get(), pKey.get(), EVP_sha256());
+    // set sign key of x509 req, EdDSA signs the message without a digest
+    if (progress)
+    {
+        progress(90);
+    }
+    const EVP_MD* digest = EVP_PKEY_id(pKey.get()) == EVP_PKEY_ED25519
+                               ? nullptr
+                               : CryptoContext::get().sha256();
+    ret = X509_REQ_sign(x509Req.get(), pKey.get(), digest);
     if (ret == 0)
     {
         log<level::ERR>("Error occurred while signing key of x509");
@@ -478,7 +946,8 @@ bool Manager::isExtendedKeyUsage(const std::string& usage)
         [&usage](const char* s) { return (strcmp(s, usage.c_str()) == 0); });
     return it != usageList.end();
 }
-EVPPkeyPtr Manager::generateRSAKeyPair(const int64_t keyBitLength)
+EVPPkeyPtr Manager::generateRSAKeyPair(const int64_t keyBitLength,
+                                       const ProgressFunc& progress)
 {
     int64_t keyBitLen = keyBitLength;
     // set keybit length to default value if not set
@@ -524,7 +993,9 @@ EVPPkeyPtr Manager::generateRSAKeyPair(const int64_t keyBitLength)
 
 #else
     auto ctx = std::unique_ptr<EVP_PKEY_CTX, decltype(&::EVP_PKEY_CTX_free)>(
-        EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr), &::EVP_PKEY_CTX_free);
+        EVP_PKEY_CTX_new_from_name(CryptoContext::get().libraryContext(),
+                                   "RSA", nullptr),
+        &::EVP_PKEY_CTX_free);
     if (!ctx)
     {
         log<level::ERR>("Error occurred creating EVP_PKEY_CTX from algorithm");
@@ -539,6 +1010,24 @@ EVPPkeyPtr Manager::generateRSAKeyPair(const int64_t keyBitLength)
         elog<InternalFailure>();
     }
 
+    // OpenSSL reports every prime found, the second one completes the key.
+    if (progress)
+    {
+        progress(5);
+        EVP_PKEY_CTX_set_app_data(ctx.get(),
+                                  const_cast<ProgressFunc*>(&progress));
+        EVP_PKEY_CTX_set_cb(ctx.get(), [](EVP_PKEY_CTX* cbCtx) {
+            if (EVP_PKEY_CTX_get_keygen_info(cbCtx, 0) == 3)
+            {
+                auto* report = static_cast<ProgressFunc*>(
+                    EVP_PKEY_CTX_get_app_data(cbCtx));
+                (*report)(EVP_PKEY_CTX_get_keygen_info(cbCtx, 1) == 0 ? 45
+                                                                      : 80);
+            }
+            return 1;
+        });
+    }
+
     EVP_PKEY* pKey = nullptr;
     if (EVP_PKEY_keygen(ctx.get(), &pKey) <= 0)
     {
@@ -614,34 +1103,41 @@ EVPPkeyPtr Manager::generateECKeyPair(const std::string& curveId)
             key, &::EVP_PKEY_free};
     };
 
-    // Create context to set up curve parameters.
+    // Curve parameters are generated once per curve and shared.
+    CryptoContext& crypto = CryptoContext::get();
     auto ctx = std::unique_ptr<EVP_PKEY_CTX, decltype(&::EVP_PKEY_CTX_free)>(
-        EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), &::EVP_PKEY_CTX_free);
-    if (!ctx)
+        EVP_PKEY_CTX_new_from_pkey(crypto.libraryContext(),
+                                   crypto.ecParameters(ecGrp), nullptr),
+        &::EVP_PKEY_CTX_free);
+
+    if (!ctx || (EVP_PKEY_keygen_init(ctx.get()) <= 0))
     {
-        log<level::ERR>("Error occurred creating EVP_PKEY_CTX for params");
+        log<level::ERR>("Error occurred initializing keygen context");
         elog<InternalFailure>();
     }
 
-    // Set up curve parameters.
-    EVP_PKEY* params = nullptr;
-
-    if ((EVP_PKEY_paramgen_init(ctx.get()) <= 0) ||
-        (EVP_PKEY_CTX_set_ec_param_enc(ctx.get(), OPENSSL_EC_NAMED_CURVE) <=
-         0) ||
-        (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx.get(), ecGrp) <= 0) ||
-        (EVP_PKEY_paramgen(ctx.get(), &params) <= 0))
+    EVP_PKEY* pKey = nullptr;
+    if (EVP_PKEY_keygen(ctx.get(), &pKey) <= 0)
     {
-        log<level::ERR>("Error occurred setting curve parameters");
+        log<level::ERR>("Error occurred during generate EC key");
         elog<InternalFailure>();
     }
 
-    // Move parameters to RAII holder.
-    auto pparms = holder_of_key(params);
-
-    // Create new context for key.
-    ctx.reset(EVP_PKEY_CTX_new_from_pkey(nullptr, params, nullptr));
+    return holder_of_key(pKey);
+#endif
+}
 
+EVPPkeyPtr Manager::generateEdDSAKeyPair()
+{
+#if (OPENSSL_VERSION_NUMBER < 0x30000000L)
+    auto ctx = std::unique_ptr<EVP_PKEY_CTX, decltype(&::EVP_PKEY_CTX_free)>(
+        EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr), &::EVP_PKEY_CTX_free);
+#else
+    auto ctx = std::unique_ptr<EVP_PKEY_CTX, decltype(&::EVP_PKEY_CTX_free)>(
+        EVP_PKEY_CTX_new_from_name(CryptoContext::get().libraryContext(),
+                                   "ED25519", nullptr),
+        &::EVP_PKEY_CTX_free);
+#endif
     if (!ctx || (EVP_PKEY_keygen_init(ctx.get()) <= 0))
     {
         log<level::ERR>("Error occurred initializing keygen context");
@@ -651,12 +1147,10 @@ EVPPkeyPtr Manager::generateECKeyPair(const std::string& curveId)
     EVP_PKEY* pKey = nullptr;
     if (EVP_PKEY_keygen(ctx.get(), &pKey) <= 0)
     {
-        log<level::ERR>("Error occurred during generate EC key");
+        log<level::ERR>("Error occurred during generate EdDSA key");
         elog<InternalFailure>();
     }
-
-    return holder_of_key(pKey);
-#endif
+    return {pKey, &::EVP_PKEY_free};
 }
 
 void Manager::writePrivateKey(const EVPPkeyPtr& pKey,
@@ -700,17 +1194,6 @@ void Manager::addEntry(X509_NAME* x509Name, const char* field,
     }
 }
 
-void Manager::createCSRObject(const Status& status)
-{
-    if (csrPtr)
-    {
-        csrPtr.reset(nullptr);
-    }
-    auto csrObjectPath = objectPath + '/' + "csr";
-    csrPtr = std::make_unique<CSR>(bus, csrObjectPath.c_str(),
-                                   certInstallPath.c_str(), status);
-}
-
 void Manager::writeCSR(const std::string& filePath, const X509ReqPtr& x509Req)
 {
     if (fs::exists(filePath))
@@ -747,52 +1230,35 @@ void Manager::writeCSR(const std::string& filePath, const X509ReqPtr& x509Req)
 
 void Manager::createCertificates()
 {
+    // Restored certificates are announced together once all are created
+    SignalBatch batch(*this);
     auto certObjectPath = objectPath + '/';
 
     if (certType == CertificateType::Authority)
     {
-        // Check whether install path is a directory.
-        if (!fs::is_directory(certInstallPath))
+        // Reading, parsing and verification run on the worker threads, only
+        // the D-Bus objects are created here.
+        std::vector<fs::path> certFiles = authorityFiles();
+        std::vector<std::future<RestoredFile>> restored;
+        restored.reserve(certFiles.size());
+        for (const auto& certFile : certFiles)
         {
-            log<level::ERR>("Certificate installation path exists and it is "
-                            "not a directory");
-            elog<InternalFailure>();
-            return;
+            restored.emplace_back(workerPool->submit(
+                [this, certFile]() { return restoreFile(certFile); }));
         }
 
-        for (auto& path : fs::directory_iterator(certInstallPath))
+        for (auto& file : restored)
         {
-            try
-            {
-                // Assume here any regular file located in certificate directory
-                // contains certificates body. Do not want to use soft links
-                // would add value.
-                if (fs::is_regular_file(path))
-                {
-                    installedCerts.emplace_back(std::make_unique<Certificate>(
-                        bus, certObjectPath + std::to_string(certIdCounter++),
-                        certType, certInstallPath, path.path(),
-                        certWatchPtr.get(), *this));
-                }
-            }
-            catch (const InternalFailure& e)
-            {
-                report<InternalFailure>();
-            }
-            catch (const InvalidCertificate& e)
-            {
-                report<InvalidCertificate>(InvalidCertificateReason(
-                    "Existing certificate file is corrupted"));
-            }
+            restoreCertificate(
+                file, certObjectPath + std::to_string(certIdCounter++));
         }
     }
     else if (fs::exists(certInstallPath))
     {
         try
         {
-            installedCerts.emplace_back(std::make_unique<Certificate>(
-                bus, certObjectPath + '1', certType, certInstallPath,
-                certInstallPath, certWatchPtr.get(), *this));
+            addRestoredCertificate(restoreFile(certInstallPath),
+                                   certObjectPath + '1');
         }
         catch (const InternalFailure& e)
         {
@@ -804,137 +1270,1068 @@ void Manager::createCertificates()
                 "Existing certificate file is corrupted"));
         }
     }
+    metadataCache->save();
 }
 
-void Manager::createRSAPrivateKeyFile()
+std::vector<fs::path> Manager::authorityFiles()
 {
-    fs::path rsaPrivateKeyFileName =
-        certParentInstallPath / defaultRSAPrivateKeyFileName;
+    // Check whether install path is a directory.
+    if (!fs::is_directory(certInstallPath))
+    {
+        log<level::ERR>("Certificate installation path exists and it is "
+                        "not a directory");
+        elog<InternalFailure>();
+    }
+
+    // Collect the certificate files first, sorted by name so that object
+    // paths are assigned in the same order on every start.
+    std::vector<fs::path> certFiles;
+    for (auto& path : fs::directory_iterator(certInstallPath))
+    {
+        try
+        {
+            // Assume here any regular file located in certificate directory
+            // contains certificates body. Do not want to use soft links
+            // would add value.
+            // Hidden files are the metadata cache and temporaries left by
+            // an interrupted publish.
+            if (fs::is_regular_file(path) && !fs::is_symlink(path) &&
+                path.path().filename().string().front() != '.')
+            {
+                certFiles.push_back(path.path());
+            }
+        }
+        catch (const fs::filesystem_error& e)
+        {
+            log<level::ERR>("Failed to check certificate file",
+                            entry("ERR=%s", e.what()),
+                            entry("FILE=%s", path.path().c_str()));
+        }
+    }
+    std::sort(certFiles.begin(), certFiles.end());
 
+    std::unordered_set<std::string> fileNames;
+    for (const auto& certFile : certFiles)
+    {
+        fileNames.insert(certFile.filename());
+    }
+    metadataCache->retain(fileNames);
+    return certFiles;
+}
+
+void Manager::restore(std::function<void()>&& done)
+{
+    restoreDone = std::move(done);
+    watchCertificates();
+
+    std::vector<std::pair<std::string, std::string>> files;
+    auto certObjectPath = objectPath + '/';
     try
     {
-        if (!fs::exists(rsaPrivateKeyFileName))
+        if (certType == CertificateType::Authority)
+        {
+            // Object paths are assigned in file order, whichever file is
+            // verified first.
+            for (const auto& certFile : authorityFiles())
+            {
+                files.emplace_back(
+                    certFile, certObjectPath + std::to_string(certIdCounter++));
+            }
+        }
+        else if (fs::exists(certInstallPath))
         {
-            writePrivateKey(generateRSAKeyPair(supportedKeyBitLength),
-                            defaultRSAPrivateKeyFileName);
+            files.emplace_back(certInstallPath, certObjectPath + '1');
         }
     }
     catch (const InternalFailure& e)
     {
         report<InternalFailure>();
     }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to list certificate files",
+                        entry("ERR=%s", e.what()));
+    }
+
+    pendingRestores = files.size();
+    if (files.empty())
+    {
+        metadataCache->save();
+        completeRestore();
+        return;
+    }
+    for (auto& [filePath, certPath] : files)
+    {
+        restoreTask(std::move(filePath), std::move(certPath));
+    }
 }
 
-EVPPkeyPtr Manager::getRSAKeyPair(const int64_t keyBitLength)
+Task Manager::restoreTask(std::string filePath, std::string certObjectPath)
 {
-    if (keyBitLength != supportedKeyBitLength)
+    // The service is only ready once every file is accounted for, a file
+    // that could not be restored must not hold up the others.
+    try
     {
-        log<level::ERR>(
-            "Given Key bit length is not supported",
-            entry("GIVENKEYBITLENGTH=%d", keyBitLength),
-            entry("SUPPORTEDKEYBITLENGTH=%d", supportedKeyBitLength));
-        elog<InvalidArgument>(
-            Argument::ARGUMENT_NAME("KEYBITLENGTH"),
-            Argument::ARGUMENT_VALUE(std::to_string(keyBitLength).c_str()));
+        auto restored = co_await onWorker(
+            [this, filePath]() { return restoreFile(filePath); });
+        restoreCertificate(restored, certObjectPath);
     }
-    fs::path rsaPrivateKeyFileName =
-        certParentInstallPath / defaultRSAPrivateKeyFileName;
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to restore certificate file",
+                        entry("ERR=%s", e.what()),
+                        entry("FILE=%s", filePath.c_str()));
+    }
+    if (--pendingRestores == 0)
+    {
+        metadataCache->save();
+        completeRestore();
+    }
+}
+
+void Manager::checkRestored() const
+{
+    if (restoring)
+    {
+        elog<NotAllowed>(
+            NotAllowedReason("Certificates are still being restored"));
+    }
+}
 
-    FILE* privateKeyFile = std::fopen(rsaPrivateKeyFileName.c_str(), "r");
-    if (!privateKeyFile)
+Manager::RestoredFile Manager::restoreFile(const std::string& filePath) const
+{
+    RestoredFile restored;
+    restored.data = readFile(filePath);
+    struct stat st = {};
+    if (stat(filePath.c_str(), &st) < 0)
     {
-        log<level::ERR>("Unable to open RSA private key file to read",
-                        entry("RSAKEYFILE=%s", rsaPrivateKeyFileName.c_str()),
-                        entry("ERRORREASON=%s", strerror(errno)));
+        log<level::ERR>("Failed to stat certificate file",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("FILE=%s", filePath.c_str()));
         elog<InternalFailure>();
     }
 
-    EVPPkeyPtr privateKey(
-        PEM_read_PrivateKey(privateKeyFile, nullptr, nullptr, nullptr),
-        ::EVP_PKEY_free);
-    std::fclose(privateKeyFile);
+    // Unchanged files that have not expired in the meantime are taken from
+    // the cache as they are.
+    restored.identity = metadataCache->find(fs::path(filePath).filename(),
+                                            makeFileKey(st, restored.data));
+    if (restored.identity &&
+        restored.identity->validNotAfter >=
+            static_cast<uint64_t>(std::time(nullptr)))
+    {
+        restored.content.sourcePath = filePath;
+        return restored;
+    }
+    restored.identity.reset();
+
+    restored.content = parseCertificate(std::move(restored.data), filePath);
+    validateCertificate(restored.content);
+    return restored;
+}
 
-    if (!privateKey)
+void Manager::addRestoredCertificate(RestoredFile&& restored,
+                                     const std::string& certObjectPath)
+{
+    if (restored.identity)
     {
-        log<level::ERR>("Error occurred during PEM_read_PrivateKey call");
-        elog<InternalFailure>();
+        installedCerts.emplace_back(std::make_unique<Certificate>(
+            bus, certObjectPath, certType, certInstallPath,
+            restored.content.sourcePath, std::move(*restored.identity),
+            certWatchPtr.get(), *this));
+        indexCertificate(installedCerts.back().get());
+        return;
     }
-    return privateKey;
+
+    installedCerts.emplace_back(std::make_unique<Certificate>(
+        bus, certObjectPath, certType, certInstallPath,
+        std::move(restored.content), certWatchPtr.get(), *this));
+    indexCertificate(installedCerts.back().get());
+    recordMetadata(*installedCerts.back());
 }
 
-void Manager::storageUpdate()
+void Manager::restoreCertificate(std::future<RestoredFile>& file,
+                                 const std::string& certObjectPath)
 {
-    if (certType == CertificateType::Authority)
+    try
     {
-        // Remove symbolic links in the certificate directory
-        for (auto& certPath : fs::directory_iterator(certInstallPath))
+        addRestoredCertificate(file.get(), certObjectPath);
+        if (authorityLinks)
         {
-            try
-            {
-                if (fs::is_symlink(certPath))
-                {
-                    fs::remove(certPath);
-                }
-            }
-            catch (const std::exception& e)
-            {
-                log<level::ERR>(
-                    "Failed to remove symlink for certificate",
-                    entry("ERR=%s", e.what()),
-                    entry("SYMLINK=%s", certPath.path().string().c_str()));
-                elog<InternalFailure>();
-            }
+            authorityLinks->add(installedCerts.back()->getCertFilePath(),
+                                installedCerts.back()->getSubjectNameHash());
         }
     }
+    catch (const InternalFailure& e)
+    {
+        report<InternalFailure>();
+    }
+    catch (const InvalidCertificate& e)
+    {
+        report<InvalidCertificate>(
+            InvalidCertificateReason("Existing certificate file is corrupted"));
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to restore certificate",
+                        entry("ERR=%s", e.what()),
+                        entry("PATH=%s", certObjectPath.c_str()));
+    }
+}
 
-    for (const auto& cert : installedCerts)
+std::optional<Manager::RefreshedFile>
+    Manager::refreshFile(const std::string& filePath) const
+{
+    std::string data = readFile(filePath);
+    struct stat st = {};
+    if (stat(filePath.c_str(), &st) < 0)
+    {
+        log<level::ERR>("Failed to stat certificate file",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("FILE=%s", filePath.c_str()));
+        elog<InternalFailure>();
+    }
+
+    RefreshedFile refreshed;
+    refreshed.key = makeFileKey(st, data);
+    if (metadataCache->find(fs::path(filePath).filename(), refreshed.key))
     {
-        cert->storageUpdate();
+        return std::nullopt;
     }
+    CertificateContent content = parseCertificate(std::move(data), filePath);
+    refreshed.identity = extractIdentity(*content.cert);
+    return refreshed;
 }
 
-void Manager::reloadOrReset(const std::string& unit)
+void Manager::recordMetadata(const Certificate& certificate)
 {
-    if (!unit.empty())
+    const std::string& filePath = certificate.getCertFilePath();
+    const std::string fileName = fs::path(filePath).filename();
+    struct stat st = {};
+    try
     {
-        try
+        // The file is read back as written, a private key may have been
+        // appended to it.
+        std::string data = readFile(filePath);
+        if (stat(filePath.c_str(), &st) < 0)
         {
-            constexpr auto defaultSystemdService = "org.freedesktop.systemd1";
-            constexpr auto defaultSystemdObjectPath =
-                "/org/freedesktop/systemd1";
-            constexpr auto defaultSystemdInterface =
-                "org.freedesktop.systemd1.Manager";
-            auto method = bus.new_method_call(
-                defaultSystemdService, defaultSystemdObjectPath,
-                defaultSystemdInterface, "ReloadOrRestartUnit");
-            method.append(unit, "replace");
-            bus.call_noreply(method);
+            metadataCache->remove(fileName);
+            return;
         }
-        catch (const sdbusplus::exception::exception& e)
+        metadataCache->update(fileName, makeFileKey(st, data),
+                              certificate.getIdentity());
+    }
+    catch (const std::exception& e)
+    {
+        metadataCache->remove(fileName);
+    }
+}
+
+void Manager::watchCertificates()
+{
+    try
+    {
+        certWatchPtr = std::make_unique<Watch>(
+            event, certInstallPath,
+            [this](const std::set<std::string>& files) { reconcile(files); },
+            certType == CertificateType::Authority);
+        if (authorityLinks)
         {
-            log<level::ERR>("Failed to reload or restart service",
-                            entry("ERR=%s", e.what()),
-                            entry("UNIT=%s", unit.c_str()));
-            elog<InternalFailure>();
+            authorityLinks->setWatch(certWatchPtr.get());
         }
     }
+    catch (const std::exception& ex)
+    {
+        log<level::ERR>("Error in watching certificate files",
+                        entry("ERROR_STR=%s", ex.what()));
+    }
 }
 
-bool Manager::isCertificateUnique(const std::string& filePath,
-                                  const Certificate* const certToDrop)
+void Manager::completeRestore()
 {
-    if (std::any_of(
-            installedCerts.begin(), installedCerts.end(),
-            [&filePath, certToDrop](std::unique_ptr<Certificate> const& cert) {
-                return cert.get() != certToDrop && cert->isSame(filePath);
-            }))
+    restoring = false;
+
+    if (certType == CertificateType::Authority)
     {
-        return false;
+        try
+        {
+            const std::string singleCertPath = "/etc/ssl/certs/Root-CA.pem";
+            if (fs::exists(singleCertPath) && !fs::is_empty(singleCertPath))
+            {
+                log<level::NOTICE>(
+                    "Legacy certificate detected, will be installed from: ",
+                    entry("SINGLE_CERTPATH=%s", singleCertPath.c_str()));
+                install(singleCertPath);
+                if (!fs::remove(singleCertPath))
+                {
+                    log<level::ERR>(
+                        "Unable to remove old certificate from: ",
+                        entry("SINGLE_CERTPATH=%s", singleCertPath.c_str()));
+                    elog<InternalFailure>();
+                }
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            log<level::ERR>("Error in restoring legacy certificate",
+                            entry("ERROR_STR=%s", ex.what()));
+        }
     }
-    else
+
+    // Files changed while they were restored may have been read before
+    // the change
+    if (!changedFiles.empty() || rescanFiles)
     {
-        return true;
+        reconcileTask();
+    }
+
+    if (restoreDone)
+    {
+        std::exchange(restoreDone, nullptr)();
     }
 }
 
+void Manager::reconcile(const std::set<std::string>& files)
+{
+    if (files.empty())
+    {
+        rescanFiles = true;
+    }
+    changedFiles.insert(files.begin(), files.end());
+
+    // The running pass may have missed the change, it is checked again
+    if (reconciling || restoring)
+    {
+        return;
+    }
+    reconcileTask();
+}
+
+Task Manager::reconcileTask()
+{
+    reconciling = true;
+    while (!changedFiles.empty() || rescanFiles)
+    {
+        auto names = std::exchange(changedFiles, {});
+        if (std::exchange(rescanFiles, false))
+        {
+            names.clear();
+        }
+        try
+        {
+            if (certType == CertificateType::Authority)
+            {
+                std::unordered_set<std::string> known;
+                for (const auto& cert : installedCerts)
+                {
+                    known.insert(cert->getCertFilePath());
+                }
+                auto scanned =
+                    co_await onWorker([this, &names, &known]() {
+                        return scanDirectory(names, known);
+                    });
+                auto files = scanned.get();
+                reconcileDirectory(files, known);
+            }
+            else if (!fs::exists(certInstallPath))
+            {
+                if (!installedCerts.empty())
+                {
+                    log<level::INFO>(
+                        "Inotify callback to delete certificate object");
+                    deleteCertificate(installedCerts[0].get());
+                }
+            }
+            // if certificate file existing update it
+            else if (!installedCerts.empty())
+            {
+                log<level::INFO>("Inotify callback to update "
+                                 "certificate properties");
+                refreshCertificate(installedCerts[0].get());
+            }
+            else
+            {
+                log<level::INFO>(
+                    "Inotify callback to create certificate object");
+                auto restored = co_await onWorker(
+                    [this]() { return restoreFile(certInstallPath); });
+                // A certificate may have been installed meanwhile
+                if (installedCerts.empty())
+                {
+                    restoreCertificate(restored, objectPath + "/1");
+                    metadataCache->save();
+                }
+            }
+        }
+        catch (const InternalFailure& e)
+        {
+            commit<InternalFailure>();
+        }
+        catch (const InvalidCertificate& e)
+        {
+            commit<InvalidCertificate>();
+        }
+        catch (const std::exception& e)
+        {
+            log<level::ERR>("Failed to reconcile certificate files",
+                            entry("ERR=%s", e.what()));
+        }
+    }
+    reconciling = false;
+}
+
+std::vector<Manager::ScannedFile>
+    Manager::scanDirectory(const std::set<std::string>& names,
+                           const std::unordered_set<std::string>& known)
+{
+    std::vector<ScannedFile> scanned;
+    if (names.empty())
+    {
+        // Events were lost, every file is checked and the known files
+        // missing from the directory are reported as removed
+        std::unordered_set<std::string> listed;
+        for (const auto& certFile : authorityFiles())
+        {
+            ScannedFile& file = scanned.emplace_back();
+            file.path = certFile;
+            listed.insert(file.path);
+        }
+        for (const auto& certFile : known)
+        {
+            if (!listed.contains(certFile))
+            {
+                scanned.emplace_back().path = certFile;
+            }
+        }
+    }
+    else
+    {
+        for (const auto& name : names)
+        {
+            scanned.emplace_back().path =
+                (fs::path(certInstallPath) / name).string();
+        }
+    }
+
+    for (auto& file : scanned)
+    {
+        // The hash links are not certificate files of their own
+        std::error_code ec;
+        file.exists = fs::is_regular_file(fs::symlink_status(file.path, ec));
+        if (!file.exists)
+        {
+            continue;
+        }
+        if (known.contains(file.path))
+        {
+            // Errors are reported when the object is refreshed
+            std::promise<RefreshedFile> refreshed;
+            try
+            {
+                auto changed = refreshFile(file.path);
+                if (!changed)
+                {
+                    continue;
+                }
+                refreshed.set_value(std::move(*changed));
+            }
+            catch (...)
+            {
+                refreshed.set_exception(std::current_exception());
+            }
+            file.refreshed = refreshed.get_future();
+            continue;
+        }
+
+        // Restored in turn, waiting on further jobs from inside a worker
+        // could starve a small pool.
+        std::promise<RestoredFile> restored;
+        try
+        {
+            restored.set_value(restoreFile(file.path));
+        }
+        catch (...)
+        {
+            restored.set_exception(std::current_exception());
+        }
+        file.restored = restored.get_future();
+    }
+    return scanned;
+}
+
+void Manager::reconcileDirectory(std::vector<ScannedFile>& scanned,
+                                 const std::unordered_set<std::string>& known)
+{
+    // The objects changed by the batch are announced together
+    SignalBatch batch(*this);
+    std::unordered_set<std::string> removed;
+    for (const auto& file : scanned)
+    {
+        if (!file.exists && known.contains(file.path))
+        {
+            removed.insert(file.path);
+        }
+    }
+
+    // Objects of removed files
+    bool changed = false;
+    for (auto it = installedCerts.begin(); it != installedCerts.end();)
+    {
+        const std::string& filePath = (*it)->getCertFilePath();
+        if (!removed.contains(filePath))
+        {
+            ++it;
+            continue;
+        }
+        log<level::INFO>("Certificate file removed, deleting its object",
+                         entry("FILE=%s", filePath.c_str()));
+        unindexCertificate(it->get());
+        if (authorityLinks)
+        {
+            authorityLinks->remove(filePath);
+        }
+        metadataCache->remove(fs::path(filePath).filename());
+        it = installedCerts.erase(it);
+        changed = true;
+    }
+
+    // Files of known certificates are refreshed if they no longer match
+    // the metadata cache, objects are created for the new files.
+    std::unordered_map<std::string, Certificate*> installed;
+    for (const auto& cert : installedCerts)
+    {
+        installed.emplace(cert->getCertFilePath(), cert.get());
+    }
+    for (auto& file : scanned)
+    {
+        auto found = installed.find(file.path);
+        if (file.restored.valid())
+        {
+            // Unless it was installed over D-Bus during the scan
+            if (found == installed.end() &&
+                addChangedFile(file.path, file.restored))
+            {
+                changed = true;
+            }
+            continue;
+        }
+        if (!file.refreshed.valid() || found == installed.end())
+        {
+            continue;
+        }
+        try
+        {
+            log<level::INFO>("Certificate file changed, updating its object",
+                             entry("FILE=%s", file.path.c_str()));
+            refreshCertificate(found->second, file.refreshed.get());
+            if (authorityLinks)
+            {
+                authorityLinks->update(file.path,
+                                       found->second->getSubjectNameHash());
+            }
+            changed = true;
+        }
+        catch (const InternalFailure& e)
+        {
+            report<InternalFailure>();
+        }
+        catch (const InvalidCertificate& e)
+        {
+            report<InvalidCertificate>(InvalidCertificateReason(
+                "Changed certificate file is corrupted"));
+        }
+    }
+
+    if (changed)
+    {
+        requestReload();
+    }
+}
+
+bool Manager::addChangedFile(const std::string& filePath,
+                             std::future<RestoredFile>& file)
+{
+    try
+    {
+        RestoredFile restored = file.get();
+        CertificateIdentity identity;
+        if (restored.identity)
+        {
+            identity = *restored.identity;
+        }
+        else
+        {
+            identity.certId = generateCertId(*restored.content.cert);
+            identity.digest = generateCertDigest(*restored.content.cert);
+        }
+        if (!isIdentityUnique(identity))
+        {
+            elog<NotAllowed>(NotAllowedReason("Certificate already exist"));
+        }
+        checkCapacity(1);
+
+        // The ID is only taken by a certificate that gets an object
+        addRestoredCertificate(std::move(restored),
+                               objectPath + '/' +
+                                   std::to_string(certIdCounter));
+        certIdCounter++;
+        if (authorityLinks)
+        {
+            authorityLinks->add(installedCerts.back()->getCertFilePath(),
+                                installedCerts.back()->getSubjectNameHash());
+        }
+        return true;
+    }
+    catch (const NotAllowed& e)
+    {
+        log<level::ERR>("Certificate file not added",
+                        entry("FILE=%s", filePath.c_str()),
+                        entry("ERR=%s", e.what()));
+    }
+    catch (const InternalFailure& e)
+    {
+        report<InternalFailure>();
+    }
+    catch (const InvalidCertificate& e)
+    {
+        report<InvalidCertificate>(InvalidCertificateReason(
+            "Added certificate file is corrupted"));
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to add certificate file",
+                        entry("FILE=%s", filePath.c_str()),
+                        entry("ERR=%s", e.what()));
+    }
+    return false;
+}
+
+void Manager::createRSAPrivateKeyFile()
+{
+    // Every CSR used to share the key of this file, they get a key of
+    // their own from the pool now.
+    fs::path rsaPrivateKeyFileName =
+        certParentInstallPath / defaultRSAPrivateKeyFileName;
+    std::error_code ec;
+    fs::remove(rsaPrivateKeyFileName, ec);
+
+    // Generating the first key takes seconds on a BMC, the service comes up
+    // meanwhile. CSRs run on the same thread in request order, so those
+    // requested before the key is ready wait for it instead of generating
+    // one more.
+    csrWorker->submit([this]() {
+        KeySpec spec{"RSA", std::to_string(defaultKeyBitLength)};
+        try
+        {
+            if (!keyPool->ready(spec))
+            {
+                keyPool->add(spec, *generateRSAKeyPair(defaultKeyBitLength));
+            }
+            keyPool->keep(spec);
+        }
+        catch (const InternalFailure& e)
+        {
+            report<InternalFailure>();
+        }
+    });
+}
+
+KeySpec Manager::csrKeySpec(int64_t keyBitLength,
+                            const std::string& keyCurveId,
+                            const std::string& keyPairAlgorithm) const
+{
+    if (keyPairAlgorithm == "RSA")
+    {
+        if (std::find(supportedKeyBitLengths.begin(),
+                      supportedKeyBitLengths.end(),
+                      keyBitLength) == supportedKeyBitLengths.end())
+        {
+            log<level::ERR>("Given Key bit length is not supported",
+                            entry("GIVENKEYBITLENGTH=%d", keyBitLength));
+            elog<InvalidArgument>(
+                Argument::ARGUMENT_NAME("KEYBITLENGTH"),
+                Argument::ARGUMENT_VALUE(std::to_string(keyBitLength).c_str()));
+        }
+        return {"RSA", std::to_string(keyBitLength)};
+    }
+
+    // Used EC algorithm as default if user did not give algorithm type.
+    if (keyPairAlgorithm == "EC" || keyPairAlgorithm.empty())
+    {
+        std::string curId(keyCurveId.empty() ? defaultKeyCurveID : keyCurveId);
+        // NIST names such as P-384 are accepted as well.
+        int ecGrp = EC_curve_nist2nid(curId.c_str());
+        if (ecGrp == NID_undef)
+        {
+            ecGrp = OBJ_txt2nid(curId.c_str());
+        }
+        const char* shortName = OBJ_nid2sn(ecGrp);
+        if (ecGrp == NID_undef || shortName == nullptr)
+        {
+            log<level::ERR>("Given EC curve is not supported",
+                            entry("KEYCURVEID=%s", curId.c_str()));
+            elog<InvalidArgument>(Argument::ARGUMENT_NAME("KEYCURVEID"),
+                                  Argument::ARGUMENT_VALUE(curId.c_str()));
+        }
+
+        // Pool entries are keyed by the short name, whatever the spelling
+        // of the request was.
+        return {"EC", shortName};
+    }
+
+    if (keyPairAlgorithm == "EdDSA")
+    {
+        if (!keyCurveId.empty() && keyCurveId != defaultEdDSACurveID)
+        {
+            log<level::ERR>("Given EdDSA curve is not supported",
+                            entry("KEYCURVEID=%s", keyCurveId.c_str()));
+            elog<InvalidArgument>(
+                Argument::ARGUMENT_NAME("KEYCURVEID"),
+                Argument::ARGUMENT_VALUE(keyCurveId.c_str()));
+        }
+        return {"EdDSA", defaultEdDSACurveID};
+    }
+
+    log<level::ERR>("Given Key pair algorithm is not supported. Supporting "
+                    "RSA, EC and EdDSA only");
+    elog<InvalidArgument>(Argument::ARGUMENT_NAME("KEYPAIRALGORITHM"),
+                          Argument::ARGUMENT_VALUE(keyPairAlgorithm.c_str()));
+}
+
+EVPPkeyPtr Manager::generateKeyPair(const KeySpec& spec,
+                                    const ProgressFunc& progress)
+{
+    if (spec.algorithm == "RSA")
+    {
+        return generateRSAKeyPair(std::stoll(spec.parameter), progress);
+    }
+    if (spec.algorithm == "EdDSA")
+    {
+        return generateEdDSAKeyPair();
+    }
+    return generateECKeyPair(spec.parameter);
+}
+
+EVPPkeyPtr Manager::pooledKeyPair(const KeySpec& spec,
+                                  const ProgressFunc& progress)
+{
+    EVPPkeyPtr pKey(nullptr, ::EVP_PKEY_free);
+    if (keyPool)
+    {
+        pKey = keyPool->take(spec);
+    }
+    if (!pKey)
+    {
+        log<level::INFO>("No pre-generated key pair ready, generating one",
+                         entry("KEYTYPE=%s", spec.name().c_str()));
+        pKey = generateKeyPair(spec, progress);
+        if (keyPool)
+        {
+            keyPool->keep(spec);
+        }
+    }
+    return pKey;
+}
+
+void Manager::storageUpdate()
+{
+    if (authorityLinks)
+    {
+        // Remove symbolic links in the certificate directory and recreate
+        // them for the known certificates
+        authorityLinks->reset();
+        for (const auto& cert : installedCerts)
+        {
+            authorityLinks->add(cert->getCertFilePath(),
+                                cert->getSubjectNameHash());
+        }
+    }
+}
+
+bool Manager::signalsDeferred() const
+{
+    return signalBatchDepth != 0;
+}
+
+void Manager::flushSignals()
+{
+    for (const auto& cert : installedCerts)
+    {
+        try
+        {
+            cert->flushSignals();
+        }
+        catch (const std::exception& e)
+        {
+            log<level::ERR>("Failed to emit certificate signals",
+                            entry("ERR=%s", e.what()),
+                            entry("FILE=%s", cert->getCertFilePath().c_str()));
+        }
+    }
+}
+
+void Manager::validateUpload(const CertificateContent& content)
+{
+    // Authority uploads may be new roots, so an incomplete chain is only
+    // an error for server and client certificates.
+    auto anchors = getTrustAnchors();
+    validateCertificate(content, storeOf(anchors),
+                        certType != CertificateType::Authority);
+}
+
+std::function<CertificateContent()>
+    Manager::uploadCheck(std::function<std::string()>&& read)
+{
+    // Authority uploads may be new roots, so an incomplete chain is only
+    // an error for server and client certificates.
+    return [read = std::move(read), anchors = getTrustAnchors(),
+            requireAnchor = certType != CertificateType::Authority]() {
+        CertificateContent content = parseCertificate(read(), "");
+        validateCertificate(content, storeOf(anchors), requireAnchor);
+        return content;
+    };
+}
+
+std::shared_ptr<TrustStore> Manager::getTrustAnchors()
+{
+    if (certType == CertificateType::Authority)
+    {
+        if (!trustStore)
+        {
+            trustStore = std::make_shared<TrustStore>();
+            syncTrustAnchors();
+        }
+        return trustStore;
+    }
+    if (trustAnchorPath.empty())
+    {
+        return nullptr;
+    }
+
+    // The authority manager keeps the hash links of the directory up to
+    // date, anchors are looked up through them when needed. The lookup is
+    // cheap, a new store only loads the anchors the verification needs.
+    auto store = std::make_shared<TrustStore>();
+    store->addDirectory(std::string(trustAnchorPath));
+    return store;
+}
+
+void Manager::syncTrustAnchors()
+{
+    if (!trustStore || certType != CertificateType::Authority)
+    {
+        return;
+    }
+
+    std::unordered_set<std::string> digests;
+    for (const auto& cert : installedCerts)
+    {
+        digests.insert(cert->getCertDigest());
+        if (trustStore->contains(cert->getCertDigest()))
+        {
+            continue;
+        }
+        try
+        {
+            CertificateContent content =
+                loadCertificate(cert->getCertFilePath());
+            trustStore->add(*content.cert);
+        }
+        catch (const std::exception& e)
+        {
+            log<level::ERR>("Failed to load trust anchor",
+                            entry("ERR=%s", e.what()),
+                            entry("FILE=%s", cert->getCertFilePath().c_str()));
+        }
+    }
+    trustStore->retain(digests);
+}
+
+void Manager::requestReload()
+{
+    syncTrustAnchors();
+    metadataCache->save();
+    if (unitToRestart.empty())
+    {
+        // Nothing to reload, files are synced when the unit reload is run.
+        syncPublishedFiles();
+    }
+    reloadScheduler->request(unitToRestart);
+}
+
+void Manager::reloadOrReset(const std::string& unit)
+{
+    // The unit is going to read the files, make them durable first.
+    syncPublishedFiles();
+
+    if (!unit.empty())
+    {
+        try
+        {
+            constexpr auto defaultSystemdService = "org.freedesktop.systemd1";
+            constexpr auto defaultSystemdObjectPath =
+                "/org/freedesktop/systemd1";
+            constexpr auto defaultSystemdInterface =
+                "org.freedesktop.systemd1.Manager";
+            auto method = bus.new_method_call(
+                defaultSystemdService, defaultSystemdObjectPath,
+                defaultSystemdInterface, "ReloadOrRestartUnit");
+            method.append(unit, "replace");
+
+            if (stopping)
+            {
+                sd_bus_error error = SD_BUS_ERROR_NULL;
+                int r = sd_bus_call(bus.get(), method.get(),
+                                    reloadTimeout.count(), &error, nullptr);
+                if (r < 0)
+                {
+                    log<level::ERR>("Failed to reload or restart service",
+                                    entry("ERR=%s", std::strerror(-r)),
+                                    entry("UNIT=%s", unit.c_str()));
+                }
+                sd_bus_error_free(&error);
+                return;
+            }
+
+            // Do not wait for systemd, the result arrives in reloadDone().
+            // Dropping the slot of an earlier call cancels its callback.
+            sd_bus_slot* slot = nullptr;
+            int r = sd_bus_call_async(bus.get(), &slot, method.get(),
+                                      &Manager::reloadDone, this,
+                                      reloadTimeout.count());
+            if (r < 0)
+            {
+                log<level::ERR>("Failed to reload or restart service",
+                                entry("ERR=%s", std::strerror(-r)),
+                                entry("UNIT=%s", unit.c_str()));
+                setReloadStatus(reloadStatusFailed);
+                return;
+            }
+            reloadCall.reset(slot);
+            setReloadStatus(reloadStatusRunning);
+        }
+        catch (const sdbusplus::exception::exception& e)
+        {
+            log<level::ERR>("Failed to reload or restart service",
+                            entry("ERR=%s", e.what()),
+                            entry("UNIT=%s", unit.c_str()));
+            setReloadStatus(reloadStatusFailed);
+        }
+    }
+}
+
+int Manager::reloadDone(sd_bus_message* reply, void* userdata,
+                        sd_bus_error* /*error*/)
+{
+    auto* manager = static_cast<Manager*>(userdata);
+    manager->reloadCall.reset();
+
+    const sd_bus_error* error = sd_bus_message_get_error(reply);
+    if (error != nullptr)
+    {
+        log<level::ERR>("Failed to reload or restart service",
+                        entry("ERR=%s", error->message ? error->message
+                                                       : error->name),
+                        entry("UNIT=%s", manager->unitToRestart.c_str()));
+        manager->setReloadStatus(reloadStatusFailed);
+    }
+    else
+    {
+        manager->setReloadStatus(reloadStatusSucceeded);
+    }
+    return 0;
+}
+
+void Manager::setReloadStatus(const std::string& status)
+{
+    if (reloadStatus != status)
+    {
+        reloadStatus = status;
+        sd_bus_emit_properties_changed(bus.get(), objectPath.c_str(),
+                                       reloadInterface, "ReloadStatus",
+                                       nullptr);
+    }
+}
+
+bool Manager::isCertificateUnique(X509& cert,
+                                  const Certificate* const certToDrop)
+{
+    CertificateIdentity identity;
+    identity.certId = generateCertId(cert);
+    identity.digest = generateCertDigest(cert);
+    return isIdentityUnique(identity, certToDrop);
+}
+
+bool Manager::isIdentityUnique(const CertificateIdentity& identity,
+                               const Certificate* const certToDrop) const
+{
+    auto indexed = [certToDrop](const auto& index, const std::string& key) {
+        auto [first, last] = index.equal_range(key);
+        return std::any_of(first, last, [certToDrop](const auto& entry) {
+            return entry.second != certToDrop;
+        });
+    };
+
+    if (indexed(certDigestIndex, identity.digest) ||
+        indexed(certIdIndex, identity.certId))
+    {
+        return false;
+    }
+    else
+    {
+        return true;
+    }
+}
+
+void Manager::indexCertificate(Certificate* const certificate)
+{
+    certIdIndex.emplace(certificate->getCertId(), certificate);
+    certDigestIndex.emplace(certificate->getCertDigest(), certificate);
+}
+
+void Manager::unindexCertificate(const Certificate* const certificate)
+{
+    auto unindex = [certificate](auto& index, const std::string& key) {
+        auto [first, last] = index.equal_range(key);
+        for (auto it = first; it != last; ++it)
+        {
+            if (it->second == certificate)
+            {
+                index.erase(it);
+                return;
+            }
+        }
+    };
+
+    unindex(certIdIndex, certificate->getCertId());
+    unindex(certDigestIndex, certificate->getCertDigest());
+}
+
+void Manager::refreshCertificate(Certificate* const certificate)
+{
+    unindexCertificate(certificate);
+    try
+    {
+        certificate->populateProperties();
+    }
+    catch (...)
+    {
+        indexCertificate(certificate);
+        throw;
+    }
+    indexCertificate(certificate);
+    recordMetadata(*certificate);
+    metadataCache->save();
+}
+
+void Manager::refreshCertificate(Certificate* const certificate,
+                                 RefreshedFile&& file)
+{
+    unindexCertificate(certificate);
+    metadataCache->update(fs::path(certificate->getCertFilePath()).filename(),
+                          file.key, file.identity);
+    certificate->refresh(std::move(file.identity));
+    indexCertificate(certificate);
+    metadataCache->save();
+}
+
 } // namespace phosphor::certs
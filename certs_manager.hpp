@@ -1,20 +1,37 @@
 #pragma once
 
+#include "async_task.hpp"
+#include "authority_links.hpp"
+#include "bus_method.hpp"
 #include "certificate.hpp"
 #include "csr.hpp"
+#include "key_pool.hpp"
+#include "loop_queue.hpp"
+#include "metadata_cache.hpp"
+#include "reload_scheduler.hpp"
+#include "trust_store.hpp"
 #include "watch.hpp"
+#include "worker_pool.hpp"
 
 #include <openssl/evp.h>
 #include <openssl/ossl_typ.h>
 #include <openssl/x509.h>
+#include <systemd/sd-bus.h>
 
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <memory>
+#include <optional>
 #include <sdbusplus/server/object.hpp>
-#include <sdeventplus/source/child.hpp>
 #include <sdeventplus/source/event.hpp>
+#include <set>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include <xyz/openbmc_project/Certs/CSR/Create/server.hpp>
 #include <xyz/openbmc_project/Certs/Install/server.hpp>
@@ -31,6 +48,12 @@ using ManagerInterface = sdbusplus::server::object_t<
     sdbusplus::xyz::openbmc_project::Collection::server::DeleteAll>;
 }
 
+/** @brief Result of a single bundle entry: status and object path */
+using BundleResult = std::pair<std::string, std::string>;
+
+/** @brief Reports the progress of a long running job in percent */
+using ProgressFunc = std::function<void(uint8_t percent)>;
+
 class Manager : public internal::ManagerInterface
 {
   public:
@@ -49,7 +72,7 @@ class Manager : public internal::ManagerInterface
     Manager& operator=(const Manager&) = delete;
     Manager(Manager&&) = delete;
     Manager& operator=(Manager&&) = delete;
-    virtual ~Manager() = default;
+    virtual ~Manager();
 
     /** @brief Constructor to put object onto bus at a dbus path.
      *  @param[in] bus - Bus to attach to.
@@ -58,10 +81,21 @@ class Manager : public internal::ManagerInterface
      *  @param[in] type - Type of the certificate.
      *  @param[in] unit - Unit consumed by this certificate.
      *  @param[in] installPath - Certificate installation path.
+     *  @param[in] deferRestore - Leave restoring the installed certificates
+     *      to restore(), so that the object is served right away.
      */
     Manager(sdbusplus::bus::bus& bus, sdeventplus::Event& event,
             const char* path, CertificateType type, const std::string& unit,
-            const std::string& installPath);
+            const std::string& installPath, bool deferRestore = false);
+
+    /** @brief Restore the installed certificates in the background, for a
+     *  manager constructed with deferRestore. Certificate objects appear
+     *  one by one as their files are verified, installs and DeleteAll are
+     *  rejected until all are restored.
+     *
+     *  @param[in] done - Called on the event loop once all are restored.
+     */
+    void restore(std::function<void()>&& done);
 
     /** @brief Implementation for Install
      *  Replace the existing certificate key file with another
@@ -73,6 +107,44 @@ class Manager : public internal::ManagerInterface
      */
     std::string install(const std::string filePath) override;
 
+    /** @brief Install a certificate that has already been read, e.g. from
+     *  a file descriptor or a PEM string passed over D-Bus.
+     *
+     *  @param[in] content - Parsed certificate.
+     *
+     *  @return Certificate object path.
+     */
+    std::string install(CertificateContent&& content);
+
+    /** @brief Install every certificate of a multi-certificate PEM file.
+     *  All entries are verified before anything is installed, one invalid
+     *  entry rejects the whole bundle. Certificates already installed are
+     *  skipped. The unit is reloaded once at the end.
+     *
+     *  @param[in] filePath - Certificate bundle file path.
+     *
+     *  @return Status and object path of every entry, in bundle order.
+     */
+    std::vector<BundleResult> installBundle(const std::string& filePath);
+
+    /** @brief Install a PEM upload without blocking the event loop. It is
+     *  read, parsed and verified on a worker thread, installed back on the
+     *  event loop, and the call is replied to with the object path then.
+     *
+     *  @param[in] call - InstallFromFd or InstallFromPEM method call.
+     *  @param[in] read - Job returning the uploaded PEM data.
+     */
+    void installAsync(sd_bus_message* call,
+                      std::function<std::string()>&& read);
+
+    /** @brief Install a bundle without blocking the event loop, the call is
+     *  replied to with the entry results once the bundle is installed.
+     *
+     *  @param[in] call - InstallBundle method call.
+     *  @param[in] filePath - Certificate bundle file path.
+     */
+    void installBundleAsync(sd_bus_message* call, const std::string& filePath);
+
     /** @brief Implementation for DeleteAll
      *  Delete all objects in the collection.
      */
@@ -87,6 +159,18 @@ class Manager : public internal::ManagerInterface
     void replaceCertificate(Certificate* const certificate,
                             const std::string& filePath);
 
+    /** @brief Replace the certificate with already parsed content.
+     */
+    void replaceCertificate(Certificate* const certificate,
+                            CertificateContent&& content);
+
+    /** @brief Replace the certificate with a PEM upload without blocking
+     *  the event loop, the call is replied to once it is replaced.
+     */
+    void replaceCertificateAsync(Certificate* const certificate,
+                                 sd_bus_message* call,
+                                 std::function<std::string()>&& read);
+
     /** @brief Generate Private key and CSR file
      *  Generates the Private key file and CSR file based on the input
      *  parameters. Validation of the parameters is callers responsibility.
@@ -169,31 +253,88 @@ class Manager : public internal::ManagerInterface
         std::string organizationalUnit, std::string state, std::string surname,
         std::string unstructuredName) override;
 
+    /** @brief Check whether a unit reload is scheduled but not yet done
+     *
+     *  @return True while the reload is pending
+     */
+    bool isReloadPending() const;
+
+    /** @brief Outcome of the last unit reload
+     *
+     *  @return None, Running, Succeeded or Failed
+     */
+    const std::string& getReloadStatus() const;
+
+    /** @brief Check whether certificate signals are held back until the
+     *  current batch of updates is complete
+     *
+     *  @return True while a batch is in progress
+     */
+    bool signalsDeferred() const;
+
     /** @brief Get reference to certificates' collection
      *
      *  @return Reference to certificates' collection
      */
     std::vector<std::unique_ptr<Certificate>>& getCertificates();
 
+    /** @brief Get the CSR object of the latest request
+     *
+     *  @return CSR object, null if no CSR was requested
+     */
+    const CSR* getCSR() const;
+
   private:
+    /** @class SignalBatch
+     *  @brief Holds back certificate signals for its lifetime, so that a
+     *  batch of updates is announced in one pass once it is complete.
+     *  Batches may be nested, the outermost one emits the signals.
+     */
+    class SignalBatch
+    {
+      public:
+        explicit SignalBatch(Manager& manager) : manager(manager)
+        {
+            manager.signalBatchDepth++;
+        }
+        SignalBatch(const SignalBatch&) = delete;
+        SignalBatch& operator=(const SignalBatch&) = delete;
+        ~SignalBatch()
+        {
+            if (--manager.signalBatchDepth == 0)
+            {
+                manager.flushSignals();
+            }
+        }
+
+      private:
+        Manager& manager;
+    };
+
+    /** @brief Emit the held back signals of all certificates */
+    void flushSignals();
+
     void generateCSRHelper(std::vector<std::string> alternativeNames,
                            std::string challengePassword, std::string city,
                            std::string commonName, std::string contactPerson,
                            std::string country, std::string email,
                            std::string givenName, std::string initials,
-                           int64_t keyBitLength, std::string keyCurveId,
+                           const KeySpec& keySpec,
                            std::string keyPairAlgorithm,
                            std::vector<std::string> keyUsage,
                            std::string organization,
                            std::string organizationalUnit, std::string state,
-                           std::string surname, std::string unstructuredName);
+                           std::string surname, std::string unstructuredName,
+                           const ProgressFunc& progress);
 
     /** @brief Generate RSA Key pair and get private key from key pair
      *  @param[in]  keyBitLength - KeyBit length.
+     *  @param[in]  progress - Progress of the generation, optional.
      *  @return     Pointer to RSA private key
      */
     std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>
-        generateRSAKeyPair(const int64_t keyBitLength);
+        generateRSAKeyPair(const int64_t keyBitLength,
+                           const ProgressFunc& progress = nullptr);
 
     /** @brief Generate EC Key pair and get private key from key pair
      *  @param[in]  p_KeyCurveId - Curve ID
@@ -202,6 +343,41 @@ class Manager : public internal::ManagerInterface
     std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>
         generateECKeyPair(const std::string& p_KeyCurveId);
 
+    /** @brief Generate Ed25519 key pair
+     *  @return     Pointer to Ed25519 private key
+     */
+    std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>
+        generateEdDSAKeyPair();
+
+    /** @brief Generate a key pair of the given type
+     *  @param[in]  spec - Key type.
+     *  @param[in]  progress - Progress of the generation, optional.
+     *  @return     Pointer to private key
+     */
+    std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>
+        generateKeyPair(const KeySpec& spec,
+                        const ProgressFunc& progress = nullptr);
+
+    /** @brief Take a key pair from the key pool, or generate it right away
+     *  if none is ready. The type is kept ready from then on.
+     *  @param[in]  spec - Key type.
+     *  @param[in]  progress - Progress of the generation, optional.
+     *  @return     Pointer to private key
+     */
+    std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>
+        pooledKeyPair(const KeySpec& spec,
+                      const ProgressFunc& progress = nullptr);
+
+    /** @brief Check the key parameters of a CSR request, InvalidArgument
+     *  is thrown for an unsupported combination.
+     *  @param[in]  keyBitLength - RSA key bit length
+     *  @param[in]  keyCurveId - EC or EdDSA curve, empty for the default
+     *  @param[in]  keyPairAlgorithm - RSA, EC or EdDSA, empty for EC
+     *  @return     Key type to take from the key pool
+     */
+    KeySpec csrKeySpec(int64_t keyBitLength, const std::string& keyCurveId,
+                       const std::string& keyPairAlgorithm) const;
+
     /** @brief Write private key data to file
      *
      *  @param[in] pKey     - pointer to private key
@@ -225,11 +401,6 @@ class Manager : public internal::ManagerInterface
      */
     bool isExtendedKeyUsage(const std::string& usage);
 
-    /** @brief Create CSR D-Bus object by reading the data in the CSR file
-     *  @param[in] statis - SUCCESS/FAILURE In CSR generation.
-     */
-    void createCSRObject(const Status& status);
-
     /** @brief Write generated CSR data to file
      *
      *  @param[in] filePath - CSR file path.
@@ -244,42 +415,336 @@ class Manager : public internal::ManagerInterface
      */
     void createCertificates();
 
+    /** @brief Certificate files of the authority directory, sorted by name
+     *  so that object paths are assigned in the same order on every start.
+     *  The metadata of other files is dropped from the cache.
+     */
+    std::vector<std::filesystem::path> authorityFiles();
+
+    /** @brief Watch for certificate files changed outside of the service,
+     *  the whole directory for authority certificates. The watch is created
+     *  before the certificates are restored, so that their objects are
+     *  created with it.
+     */
+    void watchCertificates();
+
+    /** @brief Install the legacy authority certificate once the installed
+     *  certificates are restored, and check the files changed meanwhile.
+     */
+    void completeRestore();
+
+    /** @brief Coroutine restoring one certificate file on a worker thread
+     *  and creating its object.
+     *  @param[in] filePath - Certificate file path.
+     *  @param[in] certObjectPath - Certificate object path.
+     */
+    Task restoreTask(std::string filePath, std::string certObjectPath);
+
+    /** @brief Reject changes to the collection while it is being restored
+     */
+    void checkRestored() const;
+
+    /** @brief Bring the certificate objects in line with the files after
+     *  they were changed outside of the service
+     *  @param[in] files - Names of the changed files, empty if any file of
+     *  the authority directory may have changed.
+     */
+    void reconcile(const std::set<std::string>& files);
+
+    /** @brief Coroutine of reconcile(). The files are read and checked on
+     *  a worker thread, only one pass runs at a time and changes seen
+     *  meanwhile start another one.
+     */
+    Task reconcileTask();
+
     /** @brief Create RSA private key file
-     *  Create RSA private key file by generating rsa key if not created
+     *  Make sure an RSA key is ready in the key pool and keep it filled,
+     *  the key is generated on the CSR thread without delaying startup.
+     *  The single key file of earlier versions is removed.
      */
     void createRSAPrivateKeyFile();
 
-    /** @brief Getting RSA private key
-     *  Getting RSA private key from generated file
-     *  @param[in]  keyBitLength - Key bit length
-     *  @return     Pointer to RSA key
+    /** @brief Rebuild certificate storage (remove outdated files, recreate
+     * symbolic links, etc.) from scratch. Install, replace and delete keep
+     * the storage up to date incrementally, so this is only needed when the
+     * on-disk state is unknown.
      */
-    std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>
-        getRSAKeyPair(const int64_t keyBitLength);
+    void storageUpdate();
 
-    /** @brief Update certificate storage (remove outdated files, recreate
-     * symbolic links, etc.).
+    /** @brief Verify an uploaded certificate against the trust anchors of
+     *  the certificate type.
+     *  @param[in] content - Parsed certificate context.
      */
-    void storageUpdate();
+    void validateUpload(const CertificateContent& content);
+
+    /** @brief Build the worker job reading, parsing and verifying an
+     *  upload. The trust anchors are looked up right away on the event loop
+     *  thread.
+     *  @param[in] read - Job returning the uploaded PEM data.
+     *  @return Job returning the verified certificate.
+     */
+    std::function<CertificateContent()>
+        uploadCheck(std::function<std::string()>&& read);
+
+    /** @brief Await a job run on a worker thread, the coroutine resumes on
+     *  the event loop thread. Only code after the await may touch the
+     *  manager state.
+     *  @param[in] job - Job run on a worker thread.
+     *  @return Awaitable resuming with the future of the job result.
+     */
+    template <typename Job>
+    WorkerAwaiter<std::decay_t<Job>> onWorker(Job&& job)
+    {
+        return {*workerPool, *loopQueue, std::forward<Job>(job)};
+    }
+
+    /** @brief Coroutine generating a CSR on the CSR thread and setting the
+     *  outcome on the CSR object, unless a later request replaced it.
+     *  @param[in] request - Number of the CSR request.
+     *  @param[in] job - Generates the key and CSR files.
+     */
+    Task csrTask(uint64_t request, std::function<void()> job);
+
+    /** @brief Coroutine of installAsync()
+     *  @param[in] call - Method call to reply to.
+     *  @param[in] check - Job parsing and verifying the upload.
+     */
+    Task installTask(BusCallPtr call,
+                     std::function<CertificateContent()> check);
+
+    /** @brief Coroutine of installBundleAsync()
+     *  @param[in] call - Method call to reply to.
+     *  @param[in] filePath - Certificate bundle file path.
+     *  @param[in] anchors - Trust anchors to verify the entries against.
+     */
+    Task installBundleTask(BusCallPtr call, std::string filePath,
+                           std::shared_ptr<TrustStore> anchors);
+
+    /** @brief Coroutine of replaceCertificateAsync()
+     *  @param[in] call - Method call to reply to.
+     *  @param[in] path - Object path of the certificate to replace.
+     *  @param[in] check - Job parsing and verifying the upload.
+     */
+    Task replaceTask(BusCallPtr call, std::string path,
+                     std::function<CertificateContent()> check);
+
+    /** @brief Fail if there is no room for more certificates
+     *  @param[in] count - Number of certificates about to be added.
+     */
+    void checkCapacity(size_t count) const;
+
+    /** @brief Add a verified certificate
+     *  @param[in] content - Verified certificate.
+     *  @return Certificate object path.
+     */
+    std::string addCertificate(CertificateContent&& content);
+
+    /** @brief Add the verified entries of a bundle
+     *  @param[in] entries - Verified bundle entries.
+     *  @return Status and object path of every entry.
+     */
+    std::vector<BundleResult>
+        addBundle(std::vector<CertificateContent>&& entries);
+
+    /** @brief Replace the certificate with verified content
+     *  @param[in] certificate - Installed certificate.
+     *  @param[in] content - Verified certificate.
+     */
+    void updateCertificate(Certificate* const certificate,
+                           CertificateContent&& content);
+
+    /** @brief Look up an installed certificate by its object path
+     *  @param[in] path - Certificate object path.
+     *  @return Certificate, null if it is gone.
+     */
+    Certificate* findCertificate(const std::string& path) const;
+
+    /** @brief Get the trust anchors uploads are verified against. The
+     *  authority manager uses the installed certificates, loaded once,
+     *  server and client managers the configured anchor directory.
+     *  @details OpenSSL keeps the anchors it looked up in a directory for the
+     *  life of the store, so a directory store is created per verification
+     *  and an anchor deleted from the directory is no longer trusted.
+     *  @return Trust anchors, null if there are none.
+     */
+    std::shared_ptr<TrustStore> getTrustAnchors();
+
+    /** @brief Bring the authority trust anchors in line with the installed
+     *  certificates, only changed certificates are loaded or dropped.
+     */
+    void syncTrustAnchors();
+
+    /** @brief Schedule a reload of the unit consuming the certificates.
+     *  Requests in quick succession are collapsed into a single reload.
+     */
+    void requestReload();
 
     /** @brief Systemd unit reload or reset helper function
-     *  Reload if the unit supports it and use a restart otherwise.
+     *  Reload if the unit supports it and use a restart otherwise. The call
+     *  is asynchronous, the outcome is reported through the reload status.
+     *  While the manager is destroyed the call is synchronous instead.
      *  @param[in] unit - service need to reload.
      */
     void reloadOrReset(const std::string& unit);
 
+    /** @brief Completion callback of the asynchronous unit reload */
+    static int reloadDone(sd_bus_message* reply, void* userdata,
+                          sd_bus_error* error);
+
+    /** @brief Update the reload status and signal the change
+     *  @param[in] status - New reload status.
+     */
+    void setReloadStatus(const std::string& status);
+
     /** @brief Check if provided certificate is unique across all certificates
      * on the internal list.
-     *  @param[in] certFilePath - Path to the file with certificate for
-     * uniqueness check.
+     *  @param[in] cert - Parsed certificate for uniqueness check.
      *  @param[in] certToDrop - Pointer to the certificate from the internal
      * list which should be not taken into account while uniqueness check.
      *  @return     Checking result. True if certificate is unique, false if
      * not.
      */
-    bool isCertificateUnique(const std::string& certFilePath,
+    bool isCertificateUnique(X509& cert,
                              const Certificate* const certToDrop = nullptr);
 
+    /** @brief Check if no other certificate has the same ID or digest.
+     *  @param[in] identity - Identity of the certificate.
+     *  @param[in] certToDrop - Certificate not taken into account.
+     *  @return True if the certificate is unique.
+     */
+    bool isIdentityUnique(const CertificateIdentity& identity,
+                          const Certificate* const certToDrop = nullptr) const;
+
+    /** @brief Add certificate to the ID and digest indexes
+     *  @param[in] certificate - Installed certificate.
+     */
+    void indexCertificate(Certificate* const certificate);
+
+    /** @brief Remove certificate from the ID and digest indexes
+     *  @param[in] certificate - Installed certificate.
+     */
+    void unindexCertificate(const Certificate* const certificate);
+
+    /** @brief Certificate file read back at startup */
+    struct RestoredFile
+    {
+        /** @brief File content, moved into content on a cache miss */
+        std::string data;
+
+        /** @brief Cached identity, if the file is unchanged */
+        std::optional<CertificateIdentity> identity;
+
+        /** @brief Parsed and verified content on a cache miss */
+        CertificateContent content;
+    };
+
+    /** @brief Read a certificate file, using the metadata cache if possible.
+     *  Safe to call from the worker threads.
+     *  @param[in] filePath - Certificate file path.
+     *  @return Cached identity or the parsed content.
+     */
+    RestoredFile restoreFile(const std::string& filePath) const;
+
+    /** @brief Create the D-Bus object of a restored certificate
+     *  @param[in] restored - Restored certificate file.
+     *  @param[in] certObjectPath - Certificate object path.
+     */
+    void addRestoredCertificate(RestoredFile&& restored,
+                                const std::string& certObjectPath);
+
+    /** @brief Create the object of a restored certificate and link it,
+     *  a file that failed to restore is reported and skipped.
+     *  @param[in] file - Result of restoreFile().
+     *  @param[in] certObjectPath - Certificate object path.
+     */
+    void restoreCertificate(std::future<RestoredFile>& file,
+                            const std::string& certObjectPath);
+
+    /** @brief File of a known certificate read again after it changed */
+    struct RefreshedFile
+    {
+        /** @brief Key of the new file content */
+        FileKey key;
+
+        /** @brief Identity of the new file content */
+        CertificateIdentity identity;
+    };
+
+    /** @brief Read the file of a known certificate again unless it still
+     *  matches the cache. Safe to call from the worker threads.
+     *  @param[in] filePath - Certificate file path.
+     *  @return Key and identity of the new content, nothing if unchanged.
+     */
+    std::optional<RefreshedFile> refreshFile(const std::string& filePath) const;
+
+    /** @brief Authority certificate file checked by a reconcile pass */
+    struct ScannedFile
+    {
+        /** @brief Certificate file path */
+        std::string path;
+
+        /** @brief Set if the path is a regular file */
+        bool exists = false;
+
+        /** @brief Result of refreshFile() for the file of a known
+         *  certificate that no longer matches the cache, not valid
+         *  otherwise */
+        std::future<RefreshedFile> refreshed;
+
+        /** @brief Result of restoreFile() for a new file, not valid for
+         *  the file of a known certificate */
+        std::future<RestoredFile> restored;
+    };
+
+    /** @brief Check changed authority files against the known certificates
+     *  and restore the new ones. Safe to call from the worker threads.
+     *  @param[in] names - Names of the changed files, empty to check the
+     *  whole directory.
+     *  @param[in] known - Files of the installed certificates.
+     *  @return Checked files.
+     */
+    std::vector<ScannedFile>
+        scanDirectory(const std::set<std::string>& names,
+                      const std::unordered_set<std::string>& known);
+
+    /** @brief Add, update and delete the objects of the authority files
+     *  that were added, changed or removed. Their links are updated one by
+     *  one and the unit is reloaded once for all of them.
+     *  @param[in] scanned - Result of scanDirectory().
+     *  @param[in] known - Files of the installed certificates the scan was
+     *  started with, objects installed meanwhile are left alone.
+     */
+    void reconcileDirectory(std::vector<ScannedFile>& scanned,
+                            const std::unordered_set<std::string>& known);
+
+    /** @brief Create the object of an authority file added outside of the
+     *  service. It is subject to the same limit and uniqueness checks as an
+     *  installed certificate, a file failing them is reported and skipped.
+     *  @param[in] filePath - Certificate file path.
+     *  @param[in] file - Result of restoreFile().
+     *  @return True if the object was created.
+     */
+    bool addChangedFile(const std::string& filePath,
+                        std::future<RestoredFile>& file);
+
+    /** @brief Store the identity of an installed certificate in the cache
+     *  @param[in] certificate - Installed certificate.
+     */
+    void recordMetadata(const Certificate& certificate);
+
+    /** @brief Refresh certificate properties from its file and reindex it
+     *  @param[in] certificate - Installed certificate.
+     */
+    void refreshCertificate(Certificate* const certificate);
+
+    /** @brief Reindex a certificate whose file was read again on a worker
+     *  thread and update its cache entry
+     *  @param[in] certificate - Installed certificate.
+     *  @param[in] file - Result of refreshFile().
+     */
+    void refreshCertificate(Certificate* const certificate,
+                            RefreshedFile&& file);
+
     /** @brief sdbusplus handler */
     sdbusplus::bus::bus& bus;
 
@@ -304,16 +769,91 @@ class Manager : public internal::ManagerInterface
     /** @brief pointer to CSR */
     std::unique_ptr<CSR> csrPtr = nullptr;
 
-    /** @brief SDEventPlus child pointer added to event loop */
-    std::unique_ptr<sdeventplus::source::Child> childPtr = nullptr;
-
-    /** @brief Watch on self signed certificates */
+    /** @brief Watch on the certificate file, or authority directory */
     std::unique_ptr<Watch> certWatchPtr = nullptr;
 
+    /** @brief InstallBundle D-Bus method registration */
+    BusSlotPtr bundleSlot{nullptr, ::sd_bus_slot_unref};
+
+    /** @brief Install from data D-Bus methods registration */
+    BusSlotPtr installDataSlot{nullptr, ::sd_bus_slot_unref};
+
+    /** @brief Reload state D-Bus property registration */
+    BusSlotPtr reloadSlot{nullptr, ::sd_bus_slot_unref};
+
+    /** @brief Outstanding asynchronous unit reload call */
+    BusSlotPtr reloadCall{nullptr, ::sd_bus_slot_unref};
+
+    /** @brief Set while the manager is destroyed */
+    bool stopping = false;
+
+    /** @brief Outcome of the last unit reload */
+    std::string reloadStatus = "None";
+
+    /** @brief Collapses unit reloads */
+    std::unique_ptr<ReloadScheduler> reloadScheduler;
+
+    /** @brief Authority trust anchors, created on first use */
+    std::shared_ptr<TrustStore> trustStore;
+
+    /** @brief Metadata of the installed certificate files, read by restore
+     *  jobs, so it must outlive the worker pool */
+    std::unique_ptr<MetadataCache> metadataCache;
+
+    /** @brief Completions of offloaded jobs, must outlive the worker pool */
+    std::unique_ptr<LoopQueue> loopQueue;
+
+    /** @brief Threads for parsing and verifying certificates */
+    std::unique_ptr<WorkerPool> workerPool;
+
+    /** @brief Hash links of the authority certificate directory */
+    std::unique_ptr<AuthorityLinks> authorityLinks = nullptr;
+
     /** @brief Parent path i.e certificate directory path */
     std::filesystem::path certParentInstallPath;
 
+    /** @brief Pre-generated key pairs, null for authority certificates */
+    std::unique_ptr<KeyPool> keyPool;
+
+    /** @brief Thread generating keys and CSRs, its jobs use the members
+     *  above, so it is stopped before them */
+    std::unique_ptr<WorkerPool> csrWorker;
+
+    /** @brief Number of CSR requests waiting or running */
+    size_t pendingCSRs = 0;
+
+    /** @brief Number of the latest CSR request, the one csrPtr is for */
+    uint64_t csrRequest = 0;
+
     /** @brief Certificate ID pool */
     uint64_t certIdCounter = 1;
+
+    /** @brief Set until the installed certificates are restored */
+    bool restoring = false;
+
+    /** @brief Number of certificate files still being restored */
+    size_t pendingRestores = 0;
+
+    /** @brief Set while a reconcile pass is running */
+    bool reconciling = false;
+
+    /** @brief Names of the files changed since the last reconcile pass
+     *  started */
+    std::set<std::string> changedFiles;
+
+    /** @brief Set if the whole authority directory has to be checked */
+    bool rescanFiles = false;
+
+    /** @brief Called once the installed certificates are restored */
+    std::function<void()> restoreDone;
+
+    /** @brief Number of open signal batches */
+    unsigned signalBatchDepth = 0;
+
+    /** @brief Installed certificates indexed by certificate ID */
+    std::unordered_multimap<std::string, Certificate*> certIdIndex;
+
+    /** @brief Installed certificates indexed by SHA-256 digest */
+    std::unordered_multimap<std::string, Certificate*> certDigestIndex;
 };
 } // namespace phosphor::certs
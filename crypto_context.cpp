@@ -0,0 +1,118 @@
+#include "crypto_context.hpp"
+
+#include <openssl/ec.h>
+#include <openssl/err.h>
+
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+using EVPPkeyCtxPtr =
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&::EVP_PKEY_CTX_free)>;
+} // namespace
+
+CryptoContext& CryptoContext::get()
+{
+    static CryptoContext context;
+    return context;
+}
+
+CryptoContext::CryptoContext()
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    sha256Md.reset(EVP_MD_fetch(libraryContext(), "SHA2-256", nullptr));
+    sha1Md.reset(EVP_MD_fetch(libraryContext(), "SHA1", nullptr));
+    if (!sha256Md || !sha1Md)
+    {
+        log<level::ERR>("Error occurred during EVP_MD_fetch call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+    tls.reset(SSL_CTX_new_ex(libraryContext(), nullptr, TLS_method()));
+#else
+    tls.reset(SSL_CTX_new(TLS_method()));
+#endif
+    if (!tls)
+    {
+        log<level::ERR>("Error occurred during SSL_CTX_new call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+}
+
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+OSSL_LIB_CTX* CryptoContext::libraryContext() const
+{
+    return nullptr;
+}
+#endif
+
+const EVP_MD* CryptoContext::sha256() const
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    return sha256Md.get();
+#else
+    return EVP_sha256();
+#endif
+}
+
+const EVP_MD* CryptoContext::sha1() const
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    return sha1Md.get();
+#else
+    return EVP_sha1();
+#endif
+}
+
+EVP_PKEY* CryptoContext::ecParameters(int curveNid)
+{
+    std::lock_guard<std::mutex> lock(ecMutex);
+    auto it = ecParams.find(curveNid);
+    if (it != ecParams.end())
+    {
+        return it->second.get();
+    }
+
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    EVPPkeyCtxPtr ctx(EVP_PKEY_CTX_new_from_name(libraryContext(), "EC",
+                                                 nullptr),
+                      ::EVP_PKEY_CTX_free);
+#else
+    EVPPkeyCtxPtr ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr),
+                      ::EVP_PKEY_CTX_free);
+#endif
+    EVP_PKEY* params = nullptr;
+    if (!ctx || (EVP_PKEY_paramgen_init(ctx.get()) <= 0) ||
+        (EVP_PKEY_CTX_set_ec_param_enc(ctx.get(), OPENSSL_EC_NAMED_CURVE) <=
+         0) ||
+        (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx.get(), curveNid) <= 0) ||
+        (EVP_PKEY_paramgen(ctx.get(), &params) <= 0))
+    {
+        log<level::ERR>("Error occurred setting curve parameters",
+                        entry("ECGROUP=%d", curveNid));
+        elog<InternalFailure>();
+    }
+    return ecParams
+        .emplace(curveNid, internal::EVPPkeyPtr(params, ::EVP_PKEY_free))
+        .first->second.get();
+}
+
+SSL_CTX* CryptoContext::tlsContext() const
+{
+    return tls.get();
+}
+
+} // namespace phosphor::certs
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "x509_utils.hpp"
+
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
+#include <openssl/ssl.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+#include <openssl/types.h>
+#endif
+
+namespace phosphor::certs
+{
+
+/** @class CryptoContext
+ *  @brief OpenSSL state shared by the whole process.
+ *  @details With OpenSSL 3 every use of an algorithm constant such as
+ *  EVP_sha256() and every new SSL_CTX fetches the implementations from the
+ *  providers again. The context fetches the digests once, keeps the EC
+ *  domain parameters of every curve used and holds a single SSL_CTX for
+ *  the TLS usability check. All members may be used from any thread.
+ */
+class CryptoContext
+{
+  public:
+    CryptoContext(const CryptoContext&) = delete;
+    CryptoContext& operator=(const CryptoContext&) = delete;
+    CryptoContext(CryptoContext&&) = delete;
+    CryptoContext& operator=(CryptoContext&&) = delete;
+
+    /** @brief Get the context, it is created on the first call.
+     *  @return Process-wide crypto context.
+     */
+    static CryptoContext& get();
+
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    /** @brief Library context keys are generated in.
+     *  @details This is the default library context: certificates and keys
+     *  are decoded through APIs bound to it, mixing them with objects of a
+     *  private context would need a second set of providers.
+     *  @return Library context.
+     */
+    OSSL_LIB_CTX* libraryContext() const;
+#endif
+
+    /** @brief SHA-256 digest */
+    const EVP_MD* sha256() const;
+
+    /** @brief SHA-1 digest */
+    const EVP_MD* sha1() const;
+
+    /** @brief Get the domain parameters of an elliptic curve, generated on
+     *  first use of the curve.
+     *  @param[in] curveNid - Curve NID.
+     *  @return Parameters to generate keys from.
+     */
+    EVP_PKEY* ecParameters(int curveNid);
+
+    /** @brief Get the TLS context certificates are checked against. A new
+     *  SSL object has to be created from it for every check.
+     *  @return TLS context.
+     */
+    SSL_CTX* tlsContext() const;
+
+  private:
+    CryptoContext();
+    ~CryptoContext() = default;
+
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    using EVPMDPtr = std::unique_ptr<EVP_MD, decltype(&::EVP_MD_free)>;
+
+    /** @brief Fetched SHA-256 implementation */
+    EVPMDPtr sha256Md{nullptr, ::EVP_MD_free};
+
+    /** @brief Fetched SHA-1 implementation */
+    EVPMDPtr sha1Md{nullptr, ::EVP_MD_free};
+#endif
+
+    /** @brief Shared TLS context */
+    std::unique_ptr<SSL_CTX, decltype(&::SSL_CTX_free)> tls{nullptr,
+                                                            ::SSL_CTX_free};
+
+    /** @brief Guards ecParams */
+    std::mutex ecMutex;
+
+    /** @brief EC domain parameters by curve NID */
+    std::map<int, internal::EVPPkeyPtr> ecParams;
+};
+
+} // namespace phosphor::certs
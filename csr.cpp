@@ -9,6 +9,7 @@
 #include <openssl/x509.h>
 
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <memory>
 #include <phosphor-logging/elog-errors.hpp>
@@ -26,22 +27,127 @@ using ::phosphor::logging::entry;
 using ::phosphor::logging::level;
 using ::phosphor::logging::log;
 using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
+using NotAllowedReason =
+    ::phosphor::logging::xyz::openbmc_project::Common::NotAllowed::REASON;
 namespace fs = std::filesystem;
 
 using X509ReqPtr = std::unique_ptr<X509_REQ, decltype(&::X509_REQ_free)>;
 using BIOPtr = std::unique_ptr<BIO, decltype(&::BIO_free_all)>;
 
+namespace
+{
+
+constexpr auto progressInterface = "xyz.openbmc_project.Certs.CSR.Progress";
+
+int statusGetter(sd_bus*, const char*, const char*, const char*,
+                 sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    return sd_bus_message_append(reply, "s",
+                                 static_cast<CSR*>(userdata)->getStatus());
+}
+
+int progressGetter(sd_bus*, const char*, const char*, const char*,
+                   sd_bus_message* reply, void* userdata, sd_bus_error*)
+{
+    return sd_bus_message_append(reply, "y",
+                                 static_cast<CSR*>(userdata)->getProgress());
+}
+
+const sd_bus_vtable progressVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_PROPERTY("Status", "s", statusGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+    SD_BUS_PROPERTY("Progress", "y", progressGetter, 0,
+                    SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+    SD_BUS_VTABLE_END};
+
+} // namespace
+
 CSR::CSR(sdbusplus::bus::bus& bus, const char* path, std::string&& installPath,
          const Status& status) :
     internal::CSRInterface(bus, path, true),
-    objectPath(path), certInstallPath(std::move(installPath)), csrStatus(status)
+    bus(bus), objectPath(path), certInstallPath(std::move(installPath)),
+    csrStatus(status)
+{
+    sd_bus_slot* slot = nullptr;
+    int r = sd_bus_add_object_vtable(bus.get(), &slot, objectPath.c_str(),
+                                     progressInterface, progressVtable, this);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to register CSR progress properties",
+                        entry("ERR=%s", std::strerror(-r)),
+                        entry("PATH=%s", objectPath.c_str()));
+    }
+    progressSlot.reset(slot);
+
+    if (csrStatus != Status::IN_PROGRESS)
+    {
+        csrProgress = 100;
+        // Emit deferred signal.
+        this->emit_object_added();
+    }
+}
+
+void CSR::setStatus(Status status)
+{
+    if (csrStatus == status)
+    {
+        return;
+    }
+    bool announce = csrStatus == Status::IN_PROGRESS;
+    csrStatus = status;
+    if (status == Status::SUCCESS)
+    {
+        csrProgress = 100;
+    }
+    sd_bus_emit_properties_changed(bus.get(), objectPath.c_str(),
+                                   progressInterface, "Status", "Progress",
+                                   nullptr);
+    if (announce)
+    {
+        // Emit deferred signal.
+        this->emit_object_added();
+    }
+}
+
+void CSR::setProgress(uint8_t percent)
+{
+    if (csrProgress != percent)
+    {
+        csrProgress = percent;
+        sd_bus_emit_properties_changed(bus.get(), objectPath.c_str(),
+                                       progressInterface, "Progress",
+                                       nullptr);
+    }
+}
+
+const char* CSR::getStatus() const
+{
+    switch (csrStatus)
+    {
+        case Status::SUCCESS:
+            return "Succeeded";
+        case Status::FAILURE:
+            return "Failed";
+        case Status::IN_PROGRESS:
+            break;
+    }
+    return "Running";
+}
+
+uint8_t CSR::getProgress() const
 {
-    // Emit deferred signal.
-    this->emit_object_added();
+    return csrProgress;
 }
 
 std::string CSR::csr()
 {
+    if (csrStatus == Status::IN_PROGRESS)
+    {
+        log<level::ERR>("CSR generation is in progress");
+        elog<NotAllowed>(NotAllowedReason("CSR generation is in progress"));
+    }
     if (csrStatus == Status::FAILURE)
     {
         log<level::ERR>("Failure in Generating CSR");
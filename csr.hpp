@@ -1,4 +1,8 @@
 #pragma once
+
+#include "bus_method.hpp"
+
+#include <cstdint>
 #include <sdbusplus/server/object.hpp>
 #include <string>
 #include <xyz/openbmc_project/Certs/CSR/server.hpp>
@@ -10,6 +14,7 @@ enum class Status
 {
     SUCCESS,
     FAILURE,
+    IN_PROGRESS,
 };
 
 namespace internal
@@ -32,6 +37,8 @@ class CSR : public internal::CSRInterface
     CSR& operator=(CSR&&) = delete;
 
     /** @brief Constructor to put object onto bus at a D-Bus path.
+     *  A request still in progress is announced once it is done, clients
+     *  wait for the object to appear before reading the CSR.
      *  @param[in] bus - Bus to attach to.
      *  @param[in] path - The D-Bus object path to attach at.
      *  @param[in] installPath - Certificate installation path.
@@ -43,7 +50,28 @@ class CSR : public internal::CSRInterface
      */
     std::string csr() override;
 
+    /** @brief Set the outcome of the request, announces the object once
+     *  it is no longer in progress.
+     *  @param[in] status - Status of Generate CSR request
+     */
+    void setStatus(Status status);
+
+    /** @brief Set the progress of the request
+     *  @param[in] percent - Progress in percent.
+     */
+    void setProgress(uint8_t percent);
+
+    /** @brief Status of the request for D-Bus: Running, Succeeded or
+     *  Failed */
+    const char* getStatus() const;
+
+    /** @brief Progress of the request in percent */
+    uint8_t getProgress() const;
+
   private:
+    /** @brief sdbusplus handler */
+    sdbusplus::bus::bus& bus;
+
     /** @brief object path */
     std::string objectPath;
 
@@ -52,5 +80,11 @@ class CSR : public internal::CSRInterface
 
     /** @brief Status of GenerateCSR request */
     Status csrStatus;
+
+    /** @brief Progress of GenerateCSR request in percent */
+    uint8_t csrProgress = 0;
+
+    /** @brief Progress D-Bus properties registration */
+    BusSlotPtr progressSlot{nullptr, ::sd_bus_slot_unref};
 };
 } // namespace phosphor::certs
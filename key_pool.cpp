@@ -0,0 +1,242 @@
+#include "key_pool.hpp"
+
+#include <openssl/pem.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <system_error>
+#include <utility>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace fs = std::filesystem;
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+std::string KeySpec::name() const
+{
+    return algorithm + '-' + parameter;
+}
+
+KeyPool::KeyPool(const fs::path& directory, size_t depth,
+                 Generator&& generate) :
+    directory(directory),
+    depth(depth), generate(std::move(generate))
+{
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (!ec)
+    {
+        fs::permissions(directory, fs::perms::owner_all,
+                        fs::perm_options::replace, ec);
+    }
+    if (ec)
+    {
+        log<level::ERR>("Failed to create key pool directory",
+                        entry("ERR=%s", ec.message().c_str()),
+                        entry("DIRECTORY=%s", directory.c_str()));
+        return;
+    }
+
+    // Pool files are named <algorithm>-<parameter>.<unique>.pem, hidden
+    // files are left over from a store that did not complete. Curve names
+    // may contain dashes and dots, algorithm names and the unique part do
+    // not, so the name is split from both ends. Files that do not parse
+    // could never be handed out and are removed.
+    for (const auto& file : fs::directory_iterator(directory, ec))
+    {
+        std::string name = file.path().filename().string();
+        std::string stem = file.path().stem().string();
+        size_t dot = stem.rfind('.');
+        size_t dash = stem.find('-');
+        if (name.starts_with('.') || file.path().extension() != ".pem" ||
+            dot == std::string::npos || dash == std::string::npos ||
+            dash + 1 >= dot)
+        {
+            fs::remove(file.path(), ec);
+            continue;
+        }
+        keys[{stem.substr(0, dash), stem.substr(dash + 1, dot - dash - 1)}]
+            .push_back(file.path());
+    }
+}
+
+KeyPool::~KeyPool()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+}
+
+KeyPool::KeyPtr KeyPool::take(const KeySpec& spec)
+{
+    fs::path file;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = keys.find(spec);
+        if (it == keys.end() || it->second.empty())
+        {
+            return {nullptr, ::EVP_PKEY_free};
+        }
+        file = std::move(it->second.back());
+        it->second.pop_back();
+    }
+    scheduleRefill();
+
+    KeyPtr key(nullptr, ::EVP_PKEY_free);
+    FILE* fp = std::fopen(file.c_str(), "r");
+    if (fp)
+    {
+        key.reset(PEM_read_PrivateKey(fp, nullptr, nullptr, nullptr));
+        std::fclose(fp);
+    }
+    // A key is never handed out twice.
+    std::error_code ec;
+    fs::remove(file, ec);
+    if (!key)
+    {
+        log<level::ERR>("Failed to read pooled key",
+                        entry("FILE=%s", file.c_str()));
+    }
+    return key;
+}
+
+void KeyPool::keep(const KeySpec& spec)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        kept.insert(spec);
+    }
+    scheduleRefill();
+}
+
+void KeyPool::add(const KeySpec& spec, EVP_PKEY& key)
+{
+    fs::path file = store(spec, key);
+    std::lock_guard<std::mutex> lock(mutex);
+    keys[spec].push_back(std::move(file));
+}
+
+size_t KeyPool::ready(const KeySpec& spec) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = keys.find(spec);
+    return it == keys.end() ? 0 : it->second.size();
+}
+
+void KeyPool::scheduleRefill()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (refilling || stopping)
+        {
+            return;
+        }
+        refilling = true;
+    }
+    worker.submit([this]() { refill(); });
+}
+
+void KeyPool::refill()
+{
+    // Keys are generated with otherwise idle CPU time only.
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+    std::optional<KeySpec> spec;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& candidate : kept)
+        {
+            if (!stopping && keys[candidate].size() < depth)
+            {
+                spec = candidate;
+                break;
+            }
+        }
+        if (!spec)
+        {
+            refilling = false;
+            return;
+        }
+    }
+
+    try
+    {
+        KeyPtr key = generate(*spec);
+        fs::path file = store(*spec, *key);
+        std::lock_guard<std::mutex> lock(mutex);
+        keys[*spec].push_back(std::move(file));
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to refill key pool",
+                        entry("KEYTYPE=%s", spec->name().c_str()),
+                        entry("ERR=%s", e.what()));
+        std::lock_guard<std::mutex> lock(mutex);
+        kept.erase(*spec);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        refilling = false;
+    }
+    scheduleRefill();
+}
+
+fs::path KeyPool::store(const KeySpec& spec, EVP_PKEY& key)
+{
+    // mkstemp creates the file readable by the owner only.
+    std::string unique = "XXXXXX";
+    std::string temporary =
+        (directory / ('.' + spec.name() + '.' + unique)).string();
+    int fd = mkstemp(temporary.data());
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to create key pool file",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("DIRECTORY=%s", directory.c_str()));
+        elog<InternalFailure>();
+    }
+    FILE* fp = fdopen(fd, "w");
+    if (!fp)
+    {
+        close(fd);
+        unlink(temporary.c_str());
+        log<level::ERR>("Failed to open key pool file",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("FILE=%s", temporary.c_str()));
+        elog<InternalFailure>();
+    }
+    bool written =
+        PEM_write_PrivateKey(fp, &key, nullptr, nullptr, 0, 0, nullptr) ==
+            1 &&
+        std::fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    std::fclose(fp);
+
+    unique = temporary.substr(temporary.size() - unique.size());
+    fs::path file = directory / (spec.name() + '.' + unique + ".pem");
+    if (!written || rename(temporary.c_str(), file.c_str()) != 0)
+    {
+        unlink(temporary.c_str());
+        log<level::ERR>("Failed to store key in the pool",
+                        entry("FILE=%s", file.c_str()));
+        elog<InternalFailure>();
+    }
+    return file;
+}
+
+} // namespace phosphor::certs
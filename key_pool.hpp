@@ -0,0 +1,129 @@
+#pragma once
+
+#include "worker_pool.hpp"
+
+#include <openssl/evp.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @brief Key pair type, e.g. RSA with "2048" or EC with "prime256v1" */
+struct KeySpec
+{
+    std::string algorithm;
+    std::string parameter;
+
+    bool operator<(const KeySpec& other) const
+    {
+        return std::tie(algorithm, parameter) <
+               std::tie(other.algorithm, other.parameter);
+    }
+
+    /** @brief Name used for the pool files, e.g. "RSA-2048" */
+    std::string name() const;
+};
+
+/** @class KeyPool
+ *  @brief Keeps freshly generated key pairs ready, so that a CSR does not
+ *  wait for the key generation.
+ *  @details Keys are stored as owner only PEM files in the pool directory
+ *  and survive restarts. Every key is handed out once and its file removed.
+ *  A thread running at idle priority tops every kept key type up to the
+ *  configured depth.
+ */
+class KeyPool
+{
+  public:
+    using KeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
+    using Generator = std::function<KeyPtr(const KeySpec& spec)>;
+
+    KeyPool() = delete;
+    KeyPool(const KeyPool&) = delete;
+    KeyPool& operator=(const KeyPool&) = delete;
+    KeyPool(KeyPool&&) = delete;
+    KeyPool& operator=(KeyPool&&) = delete;
+
+    /** @brief Constructor, picks up the keys stored by an earlier run.
+     *  @param[in] directory - Pool directory, created if missing.
+     *  @param[in] depth - Number of keys kept ready per key type.
+     *  @param[in] generate - Generates a key pair, called on the pool
+     *      thread, throws on failure.
+     */
+    KeyPool(const std::filesystem::path& directory, size_t depth,
+            Generator&& generate);
+
+    /** @brief Destructor, stops refilling after the key being generated. */
+    ~KeyPool();
+
+    /** @brief Take a ready key out of the pool, thread safe.
+     *  @param[in] spec - Key type.
+     *  @return Key pair, null if none is ready.
+     */
+    KeyPtr take(const KeySpec& spec);
+
+    /** @brief Keep keys of the type ready from now on and start a refill.
+     *  @param[in] spec - Key type, must be one the generator supports.
+     */
+    void keep(const KeySpec& spec);
+
+    /** @brief Add a key to the pool, e.g. one generated elsewhere.
+     *  @param[in] spec - Key type.
+     *  @param[in] key - Key pair.
+     */
+    void add(const KeySpec& spec, EVP_PKEY& key);
+
+    /** @brief Number of ready keys of the type. */
+    size_t ready(const KeySpec& spec) const;
+
+  private:
+    /** @brief Queue a refill job unless one is queued already */
+    void scheduleRefill();
+
+    /** @brief Generate a key for the first type below depth */
+    void refill();
+
+    /** @brief Store the key as a new pool file
+     *  @return Path of the file.
+     */
+    std::filesystem::path store(const KeySpec& spec, EVP_PKEY& key);
+
+    /** @brief Pool directory */
+    std::filesystem::path directory;
+
+    /** @brief Number of keys kept ready per type */
+    size_t depth;
+
+    /** @brief Key generation function */
+    Generator generate;
+
+    /** @brief Protects the members below */
+    mutable std::mutex mutex;
+
+    /** @brief Files of the ready keys by type */
+    std::map<KeySpec, std::vector<std::filesystem::path>> keys;
+
+    /** @brief Types kept ready */
+    std::set<KeySpec> kept;
+
+    /** @brief Set while a refill job is queued or running */
+    bool refilling = false;
+
+    /** @brief Set when the pool is being destroyed */
+    bool stopping = false;
+
+    /** @brief Refill thread, declared last to stop before the rest */
+    WorkerPool worker{1};
+};
+
+} // namespace phosphor::certs
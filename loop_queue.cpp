@@ -0,0 +1,90 @@
+#include "loop_queue.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <utility>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+LoopQueue::LoopQueue(const sdeventplus::Event& event)
+{
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == fd)
+    {
+        log<level::ERR>("eventfd failed",
+                        entry("ERR=%s", std::strerror(errno)));
+        elog<InternalFailure>();
+    }
+    try
+    {
+        ioPtr = std::make_unique<sdeventplus::source::IO>(
+            event, fd, EPOLLIN,
+            [this](sdeventplus::source::IO&, int, uint32_t) { dispatch(); });
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+}
+
+LoopQueue::~LoopQueue()
+{
+    ioPtr.reset();
+    close(fd);
+}
+
+void LoopQueue::post(Callback&& callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.emplace_back(std::move(callback));
+    }
+    // Only fails once the counter is about to overflow, in which case the
+    // loop has a wakeup pending anyway.
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    {
+        log<level::ERR>("Failed to wake up the event loop",
+                        entry("ERR=%s", std::strerror(errno)));
+    }
+}
+
+void LoopQueue::dispatch()
+{
+    uint64_t count = 0;
+    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        log<level::ERR>("Failed to read the event loop wakeup",
+                        entry("ERR=%s", std::strerror(errno)));
+    }
+
+    // Callbacks posted while these run wake the loop up again.
+    std::deque<Callback> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(queue);
+    }
+    for (auto& callback : ready)
+    {
+        callback();
+    }
+}
+
+} // namespace phosphor::certs
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+
+namespace phosphor::certs
+{
+
+/** @class LoopQueue
+ *  @brief Hands callbacks from worker threads to the event loop thread.
+ *  @details Posting is thread safe, the callbacks run in posting order from
+ *  the event loop, where D-Bus objects and replies may be touched. Callbacks
+ *  still queued when the queue is destroyed are dropped without running.
+ */
+class LoopQueue
+{
+  public:
+    using Callback = std::function<void()>;
+
+    LoopQueue() = delete;
+    LoopQueue(const LoopQueue&) = delete;
+    LoopQueue& operator=(const LoopQueue&) = delete;
+    LoopQueue(LoopQueue&&) = delete;
+    LoopQueue& operator=(LoopQueue&&) = delete;
+
+    /** @brief Constructor
+     *  @param[in] event - Event loop to run the callbacks on.
+     */
+    explicit LoopQueue(const sdeventplus::Event& event);
+
+    /** @brief Destructor, closes the wakeup descriptor. */
+    ~LoopQueue();
+
+    /** @brief Queue a callback for the event loop, callable from any thread.
+     *  @param[in] callback - Callback to run on the event loop thread.
+     */
+    void post(Callback&& callback);
+
+  private:
+    /** @brief Run the callbacks queued so far */
+    void dispatch();
+
+    /** @brief Wakes the event loop, counts posts since the last dispatch */
+    int fd = -1;
+
+    /** @brief SDEventPlus IO source watching the wakeup descriptor */
+    std::unique_ptr<sdeventplus::source::IO> ioPtr;
+
+    /** @brief Protects the queue */
+    std::mutex mutex;
+
+    /** @brief Callbacks waiting for the event loop */
+    std::deque<Callback> queue;
+};
+
+} // namespace phosphor::certs
@@ -19,12 +19,16 @@
 #include "argument.hpp"
 #include "certificate.hpp"
 #include "certs_manager.hpp"
+#include "crypto_context.hpp"
 
 #include <stdlib.h>
+#include <systemd/sd-daemon.h>
 #include <systemd/sd-event.h>
 
 #include <cctype>
+#include <chrono>
 #include <iostream>
+#include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/manager.hpp>
 #include <sdeventplus/event.hpp>
@@ -49,8 +53,21 @@ inline std::string capitalize(const std::string& s)
     return res;
 }
 
+inline long long elapsedMs(std::chrono::steady_clock::time_point from,
+                           std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from)
+        .count();
+}
+
 int main(int argc, char** argv)
 {
+    using ::phosphor::logging::entry;
+    using ::phosphor::logging::level;
+    using ::phosphor::logging::log;
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+
     // Read arguments.
     auto options = phosphor::certs::util::ArgumentParser(argc, argv);
 
@@ -77,6 +94,10 @@ int main(int argc, char** argv)
 
     // unit is an optional parameter
     const std::string& unit = (options)["unit"];
+
+    // Fetch the algorithms once, before any certificate is handled
+    phosphor::certs::CryptoContext::get();
+
     auto bus = sdbusplus::bus::new_default();
     auto objPath =
         std::string(objectNamePrefix) + '/' + typeStr + '/' + endpoint;
@@ -90,13 +111,27 @@ int main(int argc, char** argv)
     // Attach the bus to sd_event to service user requests
     bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
 
+    // The manager is served right away, the installed certificates are
+    // restored once the bus name is owned.
     phosphor::certs::Manager manager(bus, event, objPath.c_str(), type, unit,
-                                     path);
+                                     path, true);
+    const auto constructed = Clock::now();
 
     // Adjusting Interface name as per std convention
     auto busName = std::string(busNamePrefix) + '.' + capitalize(typeStr) +
                    '.' + capitalize(endpoint);
     bus.request_name(busName.c_str());
+    const auto named = Clock::now();
+
+    manager.restore([&]() {
+        const auto restored = Clock::now();
+        sd_notify(0, "READY=1");
+        log<level::INFO>(
+            "Certificate manager ready", entry("BUSNAME=%s", busName.c_str()),
+            entry("SETUP_MS=%lld", elapsedMs(started, constructed)),
+            entry("NAME_MS=%lld", elapsedMs(constructed, named)),
+            entry("RESTORE_MS=%lld", elapsedMs(named, restored)));
+    });
     event.loop();
     return 0;
 }
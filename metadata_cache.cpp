@@ -0,0 +1,260 @@
+#include "metadata_cache.hpp"
+
+#include "publish.hpp"
+#include "x509_utils.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <phosphor-logging/log.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+namespace fs = std::filesystem;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+
+constexpr std::string_view cacheHeader = "certs-metadata 2\n";
+
+// Every value is stored as "<length>:<bytes>\n", file names can contain any
+// character.
+void putField(std::string& out, std::string_view value)
+{
+    out += std::to_string(value.size());
+    out += ':';
+    out += value;
+    out += '\n';
+}
+
+void putNumber(std::string& out, uint64_t value)
+{
+    putField(out, std::to_string(value));
+}
+
+bool getField(std::string_view& in, std::string_view& value)
+{
+    size_t length = 0;
+    auto [ptr, ec] = std::from_chars(in.data(), in.data() + in.size(), length);
+    if (ec != std::errc() || ptr == in.data() + in.size() || *ptr != ':')
+    {
+        return false;
+    }
+    size_t start = static_cast<size_t>(ptr - in.data()) + 1;
+    if (in.size() < start + length + 1 || in[start + length] != '\n')
+    {
+        return false;
+    }
+    value = in.substr(start, length);
+    in.remove_prefix(start + length + 1);
+    return true;
+}
+
+bool getString(std::string_view& in, std::string& value)
+{
+    std::string_view field;
+    if (!getField(in, field))
+    {
+        return false;
+    }
+    value = field;
+    return true;
+}
+
+template <typename Number>
+bool getNumber(std::string_view& in, Number& value)
+{
+    std::string_view field;
+    if (!getField(in, field))
+    {
+        return false;
+    }
+    auto [ptr, ec] =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    return ec == std::errc() && ptr == field.data() + field.size();
+}
+} // namespace
+
+FileKey makeFileKey(const struct stat& st, std::string_view data)
+{
+    FileKey key;
+    key.inode = static_cast<uint64_t>(st.st_ino);
+    key.size = static_cast<uint64_t>(st.st_size);
+    key.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                st.st_mtim.tv_nsec;
+    key.digest = generateDataDigest(data);
+    return key;
+}
+
+MetadataCache::MetadataCache(const std::string& path) : path(path)
+{
+    std::error_code ec;
+    if (!fs::exists(path, ec))
+    {
+        return;
+    }
+    try
+    {
+        if (!parse(readFile(path)))
+        {
+            log<level::INFO>("Ignoring damaged certificate metadata cache",
+                             entry("FILE=%s", path.c_str()));
+            entries.clear();
+            dirty = true;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        log<level::INFO>("Failed to load certificate metadata cache",
+                         entry("ERR=%s", e.what()),
+                         entry("FILE=%s", path.c_str()));
+    }
+}
+
+std::optional<CertificateIdentity>
+    MetadataCache::find(const std::string& fileName, const FileKey& key) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(fileName);
+    if (it == entries.end() || !(it->second.key == key))
+    {
+        return std::nullopt;
+    }
+    return it->second.identity;
+}
+
+void MetadataCache::update(const std::string& fileName, const FileKey& key,
+                           const CertificateIdentity& identity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& cached = entries[fileName];
+    cached.key = key;
+    cached.identity = identity;
+    dirty = true;
+}
+
+void MetadataCache::remove(const std::string& fileName)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.erase(fileName) != 0)
+    {
+        dirty = true;
+    }
+}
+
+void MetadataCache::retain(const std::unordered_set<std::string>& fileNames)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::erase_if(entries, [this, &fileNames](const auto& item) {
+        if (fileNames.contains(item.first))
+        {
+            return false;
+        }
+        dirty = true;
+        return true;
+    });
+}
+
+void MetadataCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!entries.empty())
+    {
+        entries.clear();
+        dirty = true;
+    }
+}
+
+void MetadataCache::save()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!dirty)
+    {
+        return;
+    }
+
+    // Do not leave anything behind once the last certificate is gone.
+    if (entries.empty())
+    {
+        if (unlink(path.c_str()) < 0 && errno != ENOENT)
+        {
+            log<level::ERR>("Failed to remove certificate metadata cache",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("FILE=%s", path.c_str()));
+            return;
+        }
+        dirty = false;
+        return;
+    }
+
+    std::string data(cacheHeader);
+    putNumber(data, entries.size());
+    for (const auto& [fileName, cached] : entries)
+    {
+        putField(data, fileName);
+        putNumber(data, cached.key.inode);
+        putNumber(data, cached.key.size);
+        putField(data, std::to_string(cached.key.mtime));
+        putField(data, cached.key.digest);
+        putField(data, cached.identity.certId);
+        putField(data, cached.identity.digest);
+        putField(data, cached.identity.subjectNameHash);
+        putNumber(data, cached.identity.validNotAfter);
+    }
+
+    try
+    {
+        publishFile(path, data);
+        dirty = false;
+    }
+    catch (const std::exception& e)
+    {
+        // The cache only speeds up the start, failing to write it is not
+        // fatal.
+        log<level::ERR>("Failed to write certificate metadata cache",
+                        entry("ERR=%s", e.what()),
+                        entry("FILE=%s", path.c_str()));
+    }
+}
+
+bool MetadataCache::parse(std::string_view data)
+{
+    if (!data.starts_with(cacheHeader))
+    {
+        return false;
+    }
+    data.remove_prefix(cacheHeader.size());
+
+    size_t count = 0;
+    if (!getNumber(data, count))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string fileName;
+        Entry cached;
+        if (!getString(data, fileName) || !getNumber(data, cached.key.inode) ||
+            !getNumber(data, cached.key.size) ||
+            !getNumber(data, cached.key.mtime) ||
+            !getString(data, cached.key.digest) ||
+            !getString(data, cached.identity.certId) ||
+            !getString(data, cached.identity.digest) ||
+            !getString(data, cached.identity.subjectNameHash) ||
+            !getNumber(data, cached.identity.validNotAfter))
+        {
+            return false;
+        }
+        entries.emplace(std::move(fileName), std::move(cached));
+    }
+    return data.empty();
+}
+
+} // namespace phosphor::certs
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "cert_metadata.hpp"
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace phosphor::certs
+{
+
+/** @struct FileKey
+ *  @brief Identifies the exact content of a certificate file.
+ */
+struct FileKey
+{
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+
+    /** @brief SHA-256 digest of the whole file */
+    std::string digest;
+
+    bool operator==(const FileKey&) const = default;
+};
+
+/** @brief Build the key of a certificate file.
+ *  @param[in] st - File status.
+ *  @param[in] data - File content.
+ *  @return File key.
+ */
+FileKey makeFileKey(const struct stat& st, std::string_view data);
+
+/** @class MetadataCache
+ *  @brief Sidecar index of certificate identities, so that unchanged files
+ *  do not have to be parsed and verified again on every start.
+ *  @details Entries are keyed by file name and only used while inode, size,
+ *  modification time and content digest of the file still match. Property
+ *  values are not cached, they are decoded from the file on demand.
+ *  Worker threads may look entries up while the event loop updates others.
+ */
+class MetadataCache
+{
+  public:
+    MetadataCache() = delete;
+    MetadataCache(const MetadataCache&) = delete;
+    MetadataCache& operator=(const MetadataCache&) = delete;
+    MetadataCache(MetadataCache&&) = delete;
+    MetadataCache& operator=(MetadataCache&&) = delete;
+    ~MetadataCache() = default;
+
+    /** @brief Constructor, loads the cache file. A missing or damaged file
+     *  results in an empty cache.
+     *  @param[in] path - Cache file path.
+     */
+    explicit MetadataCache(const std::string& path);
+
+    /** @brief Look up the identity of an unchanged file.
+     *  @param[in] fileName - Certificate file name.
+     *  @param[in] key - Key of the current file content.
+     *  @return Identity if the entry matches the file.
+     */
+    std::optional<CertificateIdentity> find(const std::string& fileName,
+                                            const FileKey& key) const;
+
+    /** @brief Add or replace the entry of a file.
+     *  @param[in] fileName - Certificate file name.
+     *  @param[in] key - Key of the file content.
+     *  @param[in] identity - Certificate identity.
+     */
+    void update(const std::string& fileName, const FileKey& key,
+                const CertificateIdentity& identity);
+
+    /** @brief Drop the entry of a file.
+     *  @param[in] fileName - Certificate file name.
+     */
+    void remove(const std::string& fileName);
+
+    /** @brief Drop the entries of files that no longer exist.
+     *  @param[in] fileNames - Names of the existing files.
+     */
+    void retain(const std::unordered_set<std::string>& fileNames);
+
+    /** @brief Drop all entries. */
+    void clear();
+
+    /** @brief Write the cache file if anything changed. */
+    void save();
+
+  private:
+    /** @brief Cached state of one certificate file */
+    struct Entry
+    {
+        FileKey key;
+        CertificateIdentity identity;
+    };
+
+    /** @brief Parse the cache file content, false if it is damaged */
+    bool parse(std::string_view data);
+
+    /** @brief Cache file path */
+    std::string path;
+
+    /** @brief Protects the members below */
+    mutable std::mutex mutex;
+
+    /** @brief Entries by certificate file name */
+    std::map<std::string, Entry> entries;
+
+    /** @brief Entries changed since the last save */
+    bool dirty = false;
+};
+
+} // namespace phosphor::certs
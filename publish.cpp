@@ -0,0 +1,240 @@
+#include "config.h"
+
+#include "publish.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <mutex>
+#include <phosphor-logging/log.hpp>
+#include <set>
+#include <utility>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+namespace fs = std::filesystem;
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+/** @brief Directories with files published but not yet synced, files are
+ *  published from the worker threads too */
+std::set<std::string> unsyncedDirectories;
+
+/** @brief Guards unsyncedDirectories */
+std::mutex unsyncedMutex;
+
+class FileDescriptor
+{
+  public:
+    explicit FileDescriptor(int fd) : fd(fd)
+    {
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor()
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+    int operator()() const
+    {
+        return fd;
+    }
+
+  private:
+    int fd;
+};
+
+void publishFailed(const char* what, const std::string& path)
+{
+    log<level::ERR>("Failed to publish file", entry("STEP=%s", what),
+                    entry("ERR=%s", std::strerror(errno)),
+                    entry("FILE=%s", path.c_str()));
+    elog<InternalFailure>();
+}
+
+void writeAll(int fd, std::string_view data, const std::string& path)
+{
+    while (!data.empty())
+    {
+        ssize_t rc = write(fd, data.data(), data.size());
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            publishFailed("write", path);
+        }
+        data.remove_prefix(static_cast<size_t>(rc));
+    }
+}
+} // namespace
+
+Durability publishDurability()
+{
+    constexpr std::string_view policy = publishDurabilityPolicy;
+    if constexpr (policy == "batched")
+    {
+        return Durability::Batched;
+    }
+    else if constexpr (policy == "none")
+    {
+        return Durability::None;
+    }
+    else
+    {
+        return Durability::PerOperation;
+    }
+}
+
+void publishFile(const std::string& path, std::string_view data,
+                 mode_t mode)
+{
+    const fs::path filePath(path);
+    std::string directory = filePath.parent_path().string();
+    if (directory.empty())
+    {
+        directory = ".";
+    }
+    const std::string name = filePath.filename().string();
+    const std::string tmpName = "." + name + ".tmp";
+
+    FileDescriptor dirFd(
+        open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dirFd() < 0)
+    {
+        publishFailed("open directory", path);
+    }
+
+    // rename() replaces the inode, the new one must carry the access rights
+    // of the file it replaces.
+    struct stat current;
+    const bool replacing =
+        fstatat(dirFd(), name.c_str(), &current, 0) == 0 &&
+        S_ISREG(current.st_mode);
+    if (replacing)
+    {
+        mode = current.st_mode & 07777;
+    }
+
+    // An O_TMPFILE has no name until it is complete, nothing is left behind
+    // if we crash while writing it.
+    bool anonymous = true;
+    int rawFd = openat(dirFd(), ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0600);
+    if (rawFd < 0)
+    {
+        if (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL)
+        {
+            publishFailed("open temporary file", path);
+        }
+        anonymous = false;
+        unlinkat(dirFd(), tmpName.c_str(), 0);
+        rawFd = openat(dirFd(), tmpName.c_str(),
+                       O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0600);
+        if (rawFd < 0)
+        {
+            publishFailed("create temporary file", path);
+        }
+    }
+    FileDescriptor fd(rawFd);
+
+    try
+    {
+        // The file is created owner only, the final mode is set before any
+        // data is written and is not reduced by the umask.
+        if (replacing &&
+            (current.st_uid != geteuid() || current.st_gid != getegid()) &&
+            fchown(fd(), current.st_uid, current.st_gid) < 0)
+        {
+            publishFailed("chown temporary file", path);
+        }
+        if (fchmod(fd(), mode) < 0)
+        {
+            publishFailed("chmod temporary file", path);
+        }
+
+        writeAll(fd(), data, path);
+
+        const Durability durability = publishDurability();
+        if (durability == Durability::PerOperation && fsync(fd()) < 0)
+        {
+            publishFailed("fsync", path);
+        }
+
+        if (anonymous)
+        {
+            // linkat() cannot replace an existing file, give the file a
+            // temporary name first and rename it over the destination.
+            const std::string procPath =
+                "/proc/self/fd/" + std::to_string(fd());
+            unlinkat(dirFd(), tmpName.c_str(), 0);
+            if (linkat(AT_FDCWD, procPath.c_str(), dirFd(), tmpName.c_str(),
+                       AT_SYMLINK_FOLLOW) < 0)
+            {
+                publishFailed("link temporary file", path);
+            }
+        }
+        if (renameat(dirFd(), tmpName.c_str(), dirFd(), name.c_str()) < 0)
+        {
+            publishFailed("rename", path);
+        }
+
+        if (durability == Durability::PerOperation)
+        {
+            if (fsync(dirFd()) < 0)
+            {
+                publishFailed("fsync", directory);
+            }
+        }
+        else if (durability == Durability::Batched)
+        {
+            std::lock_guard lock(unsyncedMutex);
+            unsyncedDirectories.insert(directory);
+        }
+    }
+    catch (...)
+    {
+        unlinkat(dirFd(), tmpName.c_str(), 0);
+        throw;
+    }
+}
+
+void syncPublishedFiles()
+{
+    std::set<std::string> directories;
+    {
+        std::lock_guard lock(unsyncedMutex);
+        directories = std::exchange(unsyncedDirectories, {});
+    }
+
+    // syncfs() flushes the file data as well as the directory entries.
+    for (const auto& directory : directories)
+    {
+        FileDescriptor dirFd(
+            open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (dirFd() < 0 || syncfs(dirFd()) < 0)
+        {
+            log<level::ERR>("Failed to sync published files",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("DIRECTORY=%s", directory.c_str()));
+        }
+    }
+}
+
+} // namespace phosphor::certs
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+#include <string_view>
+
+namespace phosphor::certs
+{
+
+/** @brief When published files are flushed to storage */
+enum class Durability
+{
+    /** @brief File and directory are synced on every publish */
+    PerOperation,
+    /** @brief Directories are synced by syncPublishedFiles() */
+    Batched,
+    /** @brief Left to the kernel */
+    None,
+};
+
+/** @brief Durability policy selected at build time */
+Durability publishDurability();
+
+/** @brief Atomically replace the file with the data.
+ *  @details The data is written to an anonymous O_TMPFILE, or a hidden
+ *  temporary file where that is not supported, which is then renamed over
+ *  the destination. Readers see either the old or the new content, never a
+ *  partially written file. The new file keeps the mode and owner of the
+ *  file it replaces, the mode is only used for a new destination.
+ *  @param[in] path - Destination file path.
+ *  @param[in] data - File content.
+ *  @param[in] mode - Permissions of a new destination file.
+ */
+void publishFile(const std::string& path, std::string_view data,
+                 mode_t mode = 0644);
+
+/** @brief Flush files published since the last call, for the batched
+ *  durability policy. Does nothing for the other policies.
+ */
+void syncPublishedFiles();
+
+} // namespace phosphor::certs
@@ -0,0 +1,112 @@
+#include "reload_scheduler.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <phosphor-logging/log.hpp>
+#include <utility>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+} // namespace
+
+ReloadScheduler::ReloadScheduler(const sdeventplus::Event& event,
+                                 ReloadFunc&& reload,
+                                 std::chrono::milliseconds quietWindow,
+                                 std::chrono::milliseconds maxDelay,
+                                 PendingFunc&& pendingChanged) :
+    event(event),
+    reload(std::move(reload)), quietWindow(quietWindow),
+    maxDelay(std::max(maxDelay, quietWindow)),
+    pendingChanged(std::move(pendingChanged))
+{}
+
+ReloadScheduler::~ReloadScheduler()
+{
+    // Nothing is notified any more, the owner is going away.
+    pendingChanged = nullptr;
+    flush();
+}
+
+void ReloadScheduler::request(const std::string& unit)
+{
+    if (unit.empty())
+    {
+        return;
+    }
+
+    const bool wasPending = pending();
+    auto& state = units[unit];
+    if (!state)
+    {
+        state = std::make_unique<Unit>(
+            event, [this, unit](Timer&) { fire(unit); });
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!state->timer.isEnabled())
+    {
+        state->firstRequest = now;
+    }
+    auto delay = std::min<std::chrono::steady_clock::duration>(
+        quietWindow, state->firstRequest + maxDelay - now);
+    delay = std::max<std::chrono::steady_clock::duration>(
+        delay, std::chrono::steady_clock::duration::zero());
+    state->timer.restartOnce(
+        std::chrono::duration_cast<Timer::Duration>(delay));
+
+    if (!wasPending && pendingChanged)
+    {
+        pendingChanged();
+    }
+}
+
+void ReloadScheduler::flush()
+{
+    for (auto& [unit, state] : units)
+    {
+        if (state->timer.isEnabled())
+        {
+            fire(unit);
+        }
+    }
+}
+
+bool ReloadScheduler::pending() const
+{
+    return std::any_of(units.begin(), units.end(), [](const auto& unit) {
+        return unit.second->timer.isEnabled();
+    });
+}
+
+bool ReloadScheduler::pending(const std::string& unit) const
+{
+    auto it = units.find(unit);
+    return it != units.end() && it->second->timer.isEnabled();
+}
+
+void ReloadScheduler::fire(const std::string& unit)
+{
+    units.at(unit)->timer.setEnabled(false);
+    try
+    {
+        reload(unit);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Scheduled unit reload failed",
+                        entry("ERR=%s", e.what()),
+                        entry("UNIT=%s", unit.c_str()));
+    }
+    if (pendingChanged && !pending())
+    {
+        pendingChanged();
+    }
+}
+
+} // namespace phosphor::certs
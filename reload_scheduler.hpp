@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/utility/timer.hpp>
+#include <string>
+#include <unordered_map>
+
+namespace phosphor::certs
+{
+
+/** @class ReloadScheduler
+ *  @brief Coalesces unit reload requests on the event loop.
+ *  @details Every request for a unit restarts its quiet window, the reload
+ *  runs once no further request came in for that long. A burst of requests
+ *  never postpones the reload beyond the maximum delay counted from the
+ *  first request of the burst.
+ */
+class ReloadScheduler
+{
+  public:
+    using ReloadFunc = std::function<void(const std::string& unit)>;
+    using PendingFunc = std::function<void()>;
+
+    ReloadScheduler() = delete;
+    ReloadScheduler(const ReloadScheduler&) = delete;
+    ReloadScheduler& operator=(const ReloadScheduler&) = delete;
+    ReloadScheduler(ReloadScheduler&&) = delete;
+    ReloadScheduler& operator=(ReloadScheduler&&) = delete;
+
+    /** @brief Constructor
+     *  @param[in] event - Event loop to run the timers on.
+     *  @param[in] reload - Performs the actual reload of a unit.
+     *  @param[in] quietWindow - Time without requests before reloading.
+     *  @param[in] maxDelay - Upper bound from the first request to reload.
+     *  @param[in] pendingChanged - Called when pending() changes, optional.
+     */
+    ReloadScheduler(const sdeventplus::Event& event, ReloadFunc&& reload,
+                    std::chrono::milliseconds quietWindow,
+                    std::chrono::milliseconds maxDelay,
+                    PendingFunc&& pendingChanged = nullptr);
+
+    /** @brief Destructor, pending reloads are run right away. */
+    ~ReloadScheduler();
+
+    /** @brief Request a reload of the unit, empty unit names are ignored.
+     *  @param[in] unit - Unit to reload.
+     */
+    void request(const std::string& unit);
+
+    /** @brief Run all pending reloads now. */
+    void flush();
+
+    /** @brief Check for pending reloads of any unit. */
+    bool pending() const;
+
+    /** @brief Check for a pending reload of the unit.
+     *  @param[in] unit - Unit to check.
+     */
+    bool pending(const std::string& unit) const;
+
+  private:
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+
+    /** @brief Reload state of a single unit */
+    struct Unit
+    {
+        Unit(const sdeventplus::Event& event, Timer::Callback&& callback) :
+            timer(event, std::move(callback))
+        {}
+
+        /** @brief Expires when the unit has to be reloaded */
+        Timer timer;
+
+        /** @brief Time of the first request since the last reload */
+        std::chrono::steady_clock::time_point firstRequest;
+    };
+
+    /** @brief Reload the unit and clear its pending state
+     *  @param[in] unit - Unit to reload.
+     */
+    void fire(const std::string& unit);
+
+    /** @brief Event loop */
+    const sdeventplus::Event& event;
+
+    /** @brief Reload function */
+    ReloadFunc reload;
+
+    /** @brief Quiet window */
+    std::chrono::milliseconds quietWindow;
+
+    /** @brief Maximum delay */
+    std::chrono::milliseconds maxDelay;
+
+    /** @brief Pending state change notification */
+    PendingFunc pendingChanged;
+
+    /** @brief Per unit state, a unit is pending while its timer is enabled */
+    std::unordered_map<std::string, std::unique_ptr<Unit>> units;
+};
+
+} // namespace phosphor::certs
@@ -1,28 +1,47 @@
 #include "config.h"
 
+#include "async_task.hpp"
 #include "certificate.hpp"
 #include "certs_manager.hpp"
 #include "csr.hpp"
+#include "key_pool.hpp"
+#include "loop_queue.hpp"
+#include "publish.hpp"
+#include "reload_scheduler.hpp"
+#include "trust_store.hpp"
+#include "watch.hpp"
 
 #include <openssl/bio.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
 #include <openssl/ossl_typ.h>
 #include <openssl/pem.h>
 #include <openssl/x509.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
 #include <systemd/sd-event.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <new>
+#include <set>
 #include <sdbusplus/bus.hpp>
 #include <sdeventplus/event.hpp>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <xyz/openbmc_project/Certs/error.hpp>
@@ -38,6 +57,35 @@ namespace fs = std::filesystem;
 using ::sdbusplus::xyz::openbmc_project::Certs::Error::InvalidCertificate;
 using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 
+/** @brief Run the event loop until the condition holds or the timeout
+ *  expires, for the whole timeout if there is no condition.
+ *  @return Whether the condition holds.
+ */
+bool runEventLoop(sdeventplus::Event& event, std::chrono::milliseconds timeout,
+                  const std::function<bool()>& done = nullptr)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!(done && done()) && std::chrono::steady_clock::now() < deadline)
+    {
+        event.run(std::chrono::milliseconds(10));
+    }
+    return done && done();
+}
+
+/** @brief Run the event loop until the latest CSR request of the manager
+ *  is no longer running.
+ *  @return Whether the request succeeded.
+ */
+bool waitForCSR(sdeventplus::Event& event, const Manager& manager)
+{
+    runEventLoop(event, std::chrono::seconds(30), [&manager]() {
+        return manager.getCSR() &&
+               std::string(manager.getCSR()->getStatus()) != "Running";
+    });
+    return manager.getCSR() &&
+           std::string(manager.getCSR()->getStatus()) == "Succeeded";
+}
+
 /**
  * Class to generate certificate file and test verification of certificate file
  */
@@ -76,6 +124,7 @@ class TestCertificates : public ::testing::Test
         CSRFile = "domain.csr";
         privateKeyFile = "privkey.pem";
         rsaPrivateKeyFilePath = certDir + "/.rsaprivkey.pem";
+        keyPoolPath = certDir + "/.keypool";
         std::string cmd = "openssl req -x509 -sha256 -newkey rsa:2048 ";
         cmd += "-keyout cert.pem -out cert.pem -days 365000 -nodes";
         cmd += " -subj /O=openbmc-project.xyz/CN=localhost";
@@ -179,6 +228,7 @@ class TestCertificates : public ::testing::Test
   protected:
     sdbusplus::bus::bus bus;
     std::string certificateFile, CSRFile, privateKeyFile, rsaPrivateKeyFilePath;
+    std::string keyPoolPath;
 
     std::string certDir;
     uint64_t certId;
@@ -626,6 +676,57 @@ TEST_F(TestCertificates, TestReplaceCertificate)
     EXPECT_TRUE(fs::exists(verifyPath));
 }
 
+/** @brief Check property values follow a replaced certificate
+ */
+TEST_F(TestCertificates, TestReplaceCertificateProperties)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+    manager.install(certificateFile);
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 1);
+    EXPECT_EQ(certs[0]->subject(), "O=openbmc-project.xyz,CN=localhost");
+
+    createNewCertificate(true);
+    std::string pem = certs[0]->certificateString();
+    certs[0]->replace(certificateFile);
+    EXPECT_NE(certs[0]->subject(), "O=openbmc-project.xyz,CN=localhost");
+    EXPECT_NE(certs[0]->certificateString(), pem);
+}
+
+/** @brief Check the certificate details decoded with the properties
+ */
+TEST_F(TestCertificates, TestCertificateDetails)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+    manager.install(certificateFile);
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 1);
+
+    const CertificateMetadata& details = certs[0]->getProperties();
+    EXPECT_FALSE(details.serialNumber.empty());
+    EXPECT_EQ(details.fingerprintSHA256, certs[0]->getCertDigest());
+    EXPECT_EQ(details.fingerprintSHA1.size(), 40);
+    EXPECT_EQ(details.keyType, "RSA");
+    EXPECT_EQ(details.keySize, 2048);
+    EXPECT_EQ(details.signatureAlgorithm, "sha256WithRSAEncryption");
+    EXPECT_EQ(details.subjectKeyIdentifier, details.authorityKeyIdentifier);
+    EXPECT_TRUE(details.subjectAltNames.empty());
+}
+
 /** @brief Test replacing existing certificate
  */
 TEST_F(TestCertificates, TestAuthorityReplaceCertificate)
@@ -674,6 +775,781 @@ TEST_F(TestCertificates, TestAuthorityReplaceCertificate)
     }
 }
 
+/** @brief Check that uniqueness checks follow replace and delete
+ */
+TEST_F(TestCertificates, TestUniquenessAfterReplaceAndDelete)
+{
+    using NotAllowed =
+        sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
+    std::string endpoint("ldap");
+    std::string unit;
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(certDir));
+    MainApp mainApp(&manager);
+
+    std::string firstCert = "first.pem";
+    fs::copy_file(certificateFile, firstCert);
+    mainApp.install(firstCert);
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 1);
+
+    // Replace the first certificate, its old content is no longer installed
+    createNewCertificate(true);
+    certs[0]->replace(certificateFile);
+    EXPECT_THROW(mainApp.install(certificateFile), NotAllowed);
+    mainApp.install(firstCert);
+    EXPECT_EQ(certs.size(), 2);
+
+    // Deleted certificates can be installed again
+    certs[1]->delete_();
+    mainApp.install(firstCert);
+    EXPECT_EQ(certs.size(), 2);
+    fs::remove(firstCert);
+}
+
+/** @brief Check hash links stay consecutive when a certificate is deleted
+ */
+TEST_F(TestCertificates, TestHashLinksAfterDelete)
+{
+    std::string endpoint("ldap");
+    std::string unit;
+    CertificateType type = CertificateType::Authority;
+    std::string verifyDir(certDir);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(certDir));
+    MainApp mainApp(&manager);
+
+    // Three certificates sharing the same subject
+    mainApp.install(certificateFile);
+    createNewCertificate();
+    mainApp.install(certificateFile);
+    createNewCertificate();
+    mainApp.install(certificateFile);
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 3);
+
+    std::string hash = getCertSubjectNameHash(certificateFile);
+    std::string lastFile = certs[2]->getCertFilePath();
+    certs[0]->delete_();
+
+    EXPECT_TRUE(fs::exists(verifyDir + "/" + hash + ".0"));
+    EXPECT_TRUE(fs::exists(verifyDir + "/" + hash + ".1"));
+    EXPECT_FALSE(fs::is_symlink(verifyDir + "/" + hash + ".2"));
+    EXPECT_EQ(fs::read_symlink(verifyDir + "/" + hash + ".0"), lastFile);
+}
+
+/** @brief Check install and replace from a memfd and from PEM data
+ */
+TEST_F(TestCertificates, TestInstallFromData)
+{
+    std::string endpoint("ldap");
+    std::string unit;
+    CertificateType type = CertificateType::Authority;
+    std::string verifyDir(certDir);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(certDir));
+
+    std::string pem = readFile(certificateFile);
+    int fd = memfd_create("cert", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, pem.data(), pem.size()),
+              static_cast<ssize_t>(pem.size()));
+    fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+    manager.install(parseCertificate(readFileDescriptor(fd), ""));
+    close(fd);
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 1);
+    EXPECT_EQ(fs::path(certs[0]->getCertFilePath()).parent_path(), verifyDir);
+    EXPECT_EQ(readFile(certs[0]->getCertFilePath()), pem);
+
+    createNewCertificate(true);
+    std::string newPem = readFile(certificateFile);
+    certs[0]->replace(parseCertificate(std::string(newPem), ""));
+    EXPECT_EQ(readFile(certs[0]->getCertFilePath()), newPem);
+}
+
+/** @brief Check only sealed memfds are read, descriptors that could block
+ *  the reader or change while being read are rejected
+ */
+TEST_F(TestCertificates, TestReadUnsealedDescriptor)
+{
+    using InvalidArgument =
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+    std::string pem = readFile(certificateFile);
+
+    int pipeFds[2];
+    ASSERT_EQ(pipe(pipeFds), 0);
+    EXPECT_THROW(readFileDescriptor(pipeFds[0]), InvalidArgument);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+
+    int fd = memfd_create("cert", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, pem.data(), pem.size()),
+              static_cast<ssize_t>(pem.size()));
+    EXPECT_THROW(readFileDescriptor(fd), InvalidArgument);
+    fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW);
+    EXPECT_EQ(readFileDescriptor(fd), pem);
+
+    // The reader keeps its own copy of the descriptor
+    auto read = fileDescriptorReader(fd);
+    close(fd);
+    EXPECT_EQ(read(), pem);
+}
+
+/** @brief Check certificates have to chain up to the trust anchors and that
+ *  dropped anchors are no longer trusted
+ */
+TEST_F(TestCertificates, TestTrustStore)
+{
+    CertificateContent content = loadCertificate(certificateFile);
+    TrustStore trustStore;
+    EXPECT_THROW(validateCertificate(content, trustStore.get(), true),
+                 InvalidCertificate);
+    EXPECT_NO_THROW(validateCertificate(content, trustStore.get(), false));
+
+    trustStore.add(*content.cert);
+    EXPECT_TRUE(trustStore.contains(generateCertDigest(*content.cert)));
+    EXPECT_NO_THROW(validateCertificate(content, trustStore.get(), true));
+
+    trustStore.retain({});
+    EXPECT_FALSE(trustStore.contains(generateCertDigest(*content.cert)));
+    EXPECT_THROW(validateCertificate(content, trustStore.get(), true),
+                 InvalidCertificate);
+}
+
+/** @brief Check an anchor deleted from the anchor directory is no longer
+ *  trusted by a new directory store
+ */
+TEST_F(TestCertificates, TestTrustStoreDeletedAnchor)
+{
+    CertificateContent content = loadCertificate(certificateFile);
+    std::string anchorDir = certDir + "/anchors";
+    fs::create_directories(anchorDir);
+    std::string anchor =
+        anchorDir + "/" + generateSubjectNameHash(*content.cert) + ".0";
+    fs::copy_file(certificateFile, anchor);
+
+    TrustStore cached;
+    cached.addDirectory(anchorDir);
+    EXPECT_NO_THROW(validateCertificate(content, cached.get(), true));
+
+    fs::remove(anchor);
+    TrustStore current;
+    current.addDirectory(anchorDir);
+    EXPECT_THROW(validateCertificate(content, current.get(), true),
+                 InvalidCertificate);
+}
+
+/** @brief Check publishing replaces the file and leaves no temporaries
+ */
+TEST_F(TestCertificates, TestPublishFile)
+{
+    std::string file = certDir + "/published.pem";
+    publishFile(file, "first");
+    publishFile(file, "second");
+    syncPublishedFiles();
+    EXPECT_EQ(readFile(file), "second");
+
+    size_t entries = 0;
+    for ([[maybe_unused]] const auto& entry : fs::directory_iterator(certDir))
+    {
+        entries++;
+    }
+    EXPECT_EQ(entries, 1);
+}
+
+/** @brief Check publishing keeps the mode of the file it replaces
+ */
+TEST_F(TestCertificates, TestPublishFileMode)
+{
+    std::string file = certDir + "/published.pem";
+    publishFile(file, "key", 0600);
+    EXPECT_EQ(fs::status(file).permissions(),
+              fs::perms::owner_read | fs::perms::owner_write);
+
+    fs::permissions(file, fs::perms::owner_read | fs::perms::owner_write |
+                              fs::perms::group_read);
+    publishFile(file, "second");
+    EXPECT_EQ(readFile(file), "second");
+    EXPECT_EQ(fs::status(file).permissions(),
+              fs::perms::owner_read | fs::perms::owner_write |
+                  fs::perms::group_read);
+}
+
+/** @brief Check reload requests in quick succession are collapsed per unit
+ */
+TEST(TestReloadScheduler, CollapseRequests)
+{
+    auto event = sdeventplus::Event::get_default();
+    std::vector<std::string> reloads;
+    ReloadScheduler scheduler(
+        event,
+        [&reloads](const std::string& unit) { reloads.push_back(unit); },
+        std::chrono::milliseconds(20), std::chrono::milliseconds(100));
+
+    scheduler.request("a.service");
+    scheduler.request("a.service");
+    scheduler.request("b.service");
+    scheduler.request("a.service");
+    scheduler.request("");
+    EXPECT_TRUE(scheduler.pending("a.service"));
+    EXPECT_TRUE(scheduler.pending("b.service"));
+    EXPECT_FALSE(scheduler.pending(""));
+    EXPECT_TRUE(reloads.empty());
+
+    EXPECT_TRUE(runEventLoop(event, std::chrono::seconds(5),
+                             [&scheduler]() { return !scheduler.pending(); }));
+    std::sort(reloads.begin(), reloads.end());
+    EXPECT_EQ(reloads, (std::vector<std::string>{"a.service", "b.service"}));
+}
+
+/** @brief Check a file written in chunks and a file renamed into place
+ *  cause one callback each
+ */
+TEST(TestWatch, CoalesceChanges)
+{
+    auto event = sdeventplus::Event::get_default();
+    char dirTemplate[] = "/tmp/FakeWatch.XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::string watchedFile = dir + "/server.pem";
+    int calls = 0;
+    Watch watch(event, watchedFile,
+                [&calls](const std::set<std::string>&) { calls++; });
+
+    for (int i = 0; i < 3; ++i)
+    {
+        std::ofstream(watchedFile, std::ios::app) << "chunk\n";
+    }
+    std::ofstream(dir + "/other.pem") << "other\n";
+    runEventLoop(event, std::chrono::milliseconds(500));
+    EXPECT_EQ(calls, 1);
+
+    std::ofstream(dir + "/.server.pem.tmp") << "replaced\n";
+    fs::rename(dir + "/.server.pem.tmp", watchedFile);
+    runEventLoop(event, std::chrono::milliseconds(500));
+    EXPECT_EQ(calls, 2);
+    fs::remove_all(dir);
+}
+
+/** @brief Check writes of the service are not reported while changes of
+ *  other writers during the suppression are reported once it ends
+ */
+TEST(TestWatch, SuppressOwnWrites)
+{
+    auto event = sdeventplus::Event::get_default();
+    char dirTemplate[] = "/tmp/FakeWatch.XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::string watchedFile = dir + "/server.pem";
+    int calls = 0;
+    Watch watch(event, watchedFile,
+                [&calls](const std::set<std::string>&) { calls++; });
+
+    {
+        Watch::Suppression suppression(&watch);
+        std::ofstream(watchedFile) << "own\n";
+        suppression.written(watchedFile);
+    }
+    runEventLoop(event, std::chrono::milliseconds(500));
+    EXPECT_EQ(calls, 0);
+
+    {
+        Watch::Suppression suppression(&watch);
+        std::ofstream(watchedFile) << "own\n";
+        suppression.written(watchedFile);
+        runEventLoop(event, std::chrono::milliseconds(50));
+        std::ofstream(watchedFile, std::ios::app) << "other\n";
+        runEventLoop(event, std::chrono::milliseconds(200));
+        EXPECT_EQ(calls, 0);
+    }
+    runEventLoop(event, std::chrono::milliseconds(500));
+    EXPECT_EQ(calls, 1);
+    fs::remove_all(dir);
+}
+
+/** @brief Check a directory watch reports the names of the changed files,
+ *  including linked ones, and leaves out files written by the service
+ */
+TEST(TestWatch, DirectoryChanges)
+{
+    auto event = sdeventplus::Event::get_default();
+    char dirTemplate[] = "/tmp/FakeWatch.XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::vector<std::set<std::string>> calls;
+    Watch watch(
+        event, dir,
+        [&calls](const std::set<std::string>& files) {
+            calls.push_back(files);
+        },
+        true);
+
+    std::ofstream(dir + "/a.pem") << "a\n";
+    fs::create_hard_link(dir + "/a.pem", dir + "/b.pem");
+    std::ofstream(dir + "/.metadata") << "hidden\n";
+    runEventLoop(event, std::chrono::milliseconds(500));
+    ASSERT_EQ(calls.size(), 1);
+    EXPECT_EQ(calls[0], (std::set<std::string>{"a.pem", "b.pem"}));
+
+    {
+        Watch::Suppression suppression(&watch);
+        std::ofstream(dir + "/c.pem") << "own\n";
+        suppression.written(dir + "/c.pem");
+    }
+    runEventLoop(event, std::chrono::milliseconds(500));
+    EXPECT_EQ(calls.size(), 1);
+    fs::remove_all(dir);
+}
+
+/** @brief Check hash links and removals made by the service do not call
+ *  back
+ */
+TEST(TestWatch, OwnLinksAndRemovals)
+{
+    auto event = sdeventplus::Event::get_default();
+    char dirTemplate[] = "/tmp/FakeWatch.XXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    std::ofstream(dir + "/a.pem") << "a\n";
+    std::ofstream(dir + "/b.pem") << "b\n";
+    std::vector<std::set<std::string>> calls;
+    Watch watch(
+        event, dir,
+        [&calls](const std::set<std::string>& files) {
+            calls.push_back(files);
+        },
+        true);
+    AuthorityLinks links(dir);
+    links.setWatch(&watch);
+
+    links.add(dir + "/a.pem", "00000000");
+    links.add(dir + "/b.pem", "00000000");
+    links.remove(dir + "/a.pem");
+    {
+        Watch::Suppression suppression(&watch);
+        fs::remove(dir + "/a.pem");
+        suppression.written(dir + "/a.pem");
+    }
+    runEventLoop(event, std::chrono::milliseconds(500));
+    EXPECT_TRUE(calls.empty());
+    EXPECT_EQ(fs::read_symlink(dir + "/00000000.0"), dir + "/b.pem");
+
+    // Somebody else removing the link is still seen
+    fs::remove(dir + "/00000000.0");
+    runEventLoop(event, std::chrono::milliseconds(500));
+    ASSERT_EQ(calls.size(), 1);
+    EXPECT_EQ(calls[0], (std::set<std::string>{"00000000.0"}));
+    fs::remove_all(dir);
+}
+
+/** @brief Check callbacks posted from other threads run in order on the
+ *  event loop
+ */
+TEST(TestLoopQueue, PostFromThreads)
+{
+    auto event = sdeventplus::Event::get_default();
+    LoopQueue loopQueue(event);
+    std::vector<int> order;
+    std::thread poster([&loopQueue, &order]() {
+        for (int i = 0; i < 3; ++i)
+        {
+            loopQueue.post([&order, i]() { order.push_back(i); });
+        }
+    });
+    poster.join();
+    EXPECT_TRUE(order.empty());
+
+    runEventLoop(event, std::chrono::seconds(5),
+                 [&order]() { return order.size() == 3; });
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+Task doubleOnWorker(WorkerPool& pool, LoopQueue& loopQueue, int value,
+                    std::vector<int>& results)
+{
+    auto result = co_await WorkerAwaiter(pool, loopQueue,
+                                         [value]() { return value * 2; });
+    results.push_back(result.get());
+}
+
+/** @brief Check coroutines awaiting worker jobs resume on the event loop
+ */
+TEST(TestTask, AwaitWorker)
+{
+    auto event = sdeventplus::Event::get_default();
+    LoopQueue loopQueue(event);
+    WorkerPool pool(2);
+    std::vector<int> results;
+    for (int i = 0; i < 3; ++i)
+    {
+        doubleOnWorker(pool, loopQueue, i, results);
+    }
+
+    runEventLoop(event, std::chrono::seconds(5),
+                 [&results]() { return results.size() == 3; });
+    std::sort(results.begin(), results.end());
+    EXPECT_EQ(results, (std::vector<int>{0, 2, 4}));
+}
+
+/** @brief Check bundle install creates one object per new certificate
+ */
+TEST_F(TestCertificates, TestInstallBundle)
+{
+    std::string endpoint("ldap");
+    std::string unit;
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(certDir));
+    MainApp mainApp(&manager);
+
+    std::string bundleFile = "bundle.pem";
+    std::ofstream bundle(bundleFile);
+    for (int i = 0; i < 3; ++i)
+    {
+        createNewCertificate(true);
+        std::ifstream cert(certificateFile);
+        bundle << cert.rdbuf();
+    }
+    bundle.close();
+
+    // Last certificate of the bundle is already installed
+    mainApp.install(certificateFile);
+
+    std::vector<BundleResult> results = manager.installBundle(bundleFile);
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results[0].first, "Installed");
+    EXPECT_EQ(results[1].first, "Installed");
+    EXPECT_EQ(results[2].first, "Duplicate");
+    EXPECT_EQ(results[2].second, "");
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 3);
+    EXPECT_EQ(results[0].second, objPath + "/2");
+    EXPECT_EQ(results[1].second, objPath + "/3");
+    fs::remove(bundleFile);
+}
+
+/** @brief Check an install whose link cannot be created leaves no object
+ *  behind and does not hand its object path to the next install
+ */
+TEST_F(TestCertificates, TestInstallLinkFailure)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+
+    // A directory in the place of the link cannot be replaced
+    CertificateContent content = loadCertificate(certificateFile);
+    std::string link =
+        certDir + "/" + generateSubjectNameHash(*content.cert) + ".0";
+    fs::create_directories(link + "/busy");
+    EXPECT_THROW(manager.install(certificateFile), InternalFailure);
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    EXPECT_TRUE(certs.empty());
+
+    fs::remove_all(link);
+    manager.install(certificateFile);
+    ASSERT_EQ(certs.size(), 1);
+    EXPECT_EQ(certs[0]->getObjectPath(), objPath + "/2");
+    EXPECT_EQ(fs::read_symlink(link), certs[0]->getCertFilePath());
+}
+
+/** @brief Check every entry of a bundle placed in the install directory
+ *  gets a file of its own
+ */
+TEST_F(TestCertificates, TestInstallBundleInInstallDir)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+
+    std::string bundleFile = certDir + "/bundle.pem";
+    std::ofstream bundle(bundleFile);
+    for (int i = 0; i < 2; ++i)
+    {
+        createNewCertificate(true);
+        std::ifstream cert(certificateFile);
+        bundle << cert.rdbuf();
+    }
+    bundle.close();
+
+    std::vector<BundleResult> results = manager.installBundle(bundleFile);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0].first, "Installed");
+    EXPECT_EQ(results[1].first, "Installed");
+
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 2);
+    std::string firstFile = certs[0]->getCertFilePath();
+    std::string secondFile = certs[1]->getCertFilePath();
+    EXPECT_NE(firstFile, bundleFile);
+    EXPECT_NE(secondFile, bundleFile);
+    EXPECT_NE(firstFile, secondFile);
+
+    // Deleting one entry leaves the other one and the bundle alone
+    certs[0]->delete_();
+    ASSERT_EQ(certs.size(), 1);
+    EXPECT_FALSE(fs::exists(firstFile));
+    EXPECT_TRUE(fs::exists(secondFile));
+    EXPECT_TRUE(fs::exists(bundleFile));
+    fs::remove(bundleFile);
+}
+
+/** @brief Check authority certificates are restored in file name order
+ */
+TEST_F(TestCertificates, TestRestoreAuthorityCertificates)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    std::string verifyDir(certDir);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    {
+        Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+        MainApp mainApp(&manager);
+        mainApp.install(certificateFile);
+        createNewCertificate(true);
+        mainApp.install(certificateFile);
+        createNewCertificate(true);
+        mainApp.install(certificateFile);
+        EXPECT_EQ(manager.getCertificates().size(), 3);
+    }
+
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 3);
+    for (size_t i = 1; i < certs.size(); ++i)
+    {
+        EXPECT_LT(certs[i - 1]->getCertFilePath(),
+                  certs[i]->getCertFilePath());
+    }
+    for (const auto& cert : certs)
+    {
+        std::string link = verifyDir + "/" + cert->getSubjectNameHash() + ".0";
+        EXPECT_EQ(fs::read_symlink(link), cert->getCertFilePath());
+    }
+}
+
+/** @brief Check a deferred restore serves the manager first, rejects
+ *  installs meanwhile and creates the objects in file name order
+ */
+TEST_F(TestCertificates, TestDeferredRestore)
+{
+    using NotAllowed =
+        sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    {
+        Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+        MainApp mainApp(&manager);
+        mainApp.install(certificateFile);
+        createNewCertificate(true);
+        mainApp.install(certificateFile);
+        EXPECT_EQ(manager.getCertificates().size(), 2);
+    }
+
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir, true);
+    MainApp mainApp(&manager);
+    EXPECT_TRUE(manager.getCertificates().empty());
+    createNewCertificate(true);
+    EXPECT_THROW(mainApp.install(certificateFile), NotAllowed);
+
+    bool restored = false;
+    manager.restore([&restored]() { restored = true; });
+    ASSERT_TRUE(runEventLoop(event, std::chrono::seconds(5),
+                             [&restored]() { return restored; }));
+    // Objects are created as files are verified, paths follow file names.
+    std::map<std::string, std::string> files;
+    for (const auto& cert : manager.getCertificates())
+    {
+        files[cert->getObjectPath()] = cert->getCertFilePath();
+    }
+    ASSERT_EQ(files.size(), 2);
+    EXPECT_LT(files[objPath + "/1"], files[objPath + "/2"]);
+    EXPECT_NO_THROW(mainApp.install(certificateFile));
+}
+
+/** @brief Check files added to and removed from the authority directory
+ *  are reflected by the objects without a restart
+ */
+TEST_F(TestCertificates, TestAuthorityReconcile)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+    std::vector<std::unique_ptr<Certificate>>& certs =
+        manager.getCertificates();
+    ASSERT_EQ(certs.size(), 1);
+    std::string installedFile = certs[0]->getCertFilePath();
+
+    runEventLoop(event, std::chrono::milliseconds(500));
+    EXPECT_EQ(certs.size(), 1);
+
+    createNewCertificate(true);
+    std::string droppedFile = certDir + "/dropped.pem";
+    fs::copy_file(certificateFile, droppedFile);
+    fs::remove(installedFile);
+    runEventLoop(event, std::chrono::milliseconds(1000));
+    ASSERT_EQ(certs.size(), 1);
+    EXPECT_EQ(certs[0]->getCertFilePath(), droppedFile);
+    EXPECT_EQ(certs[0]->getObjectPath(), objPath + "/2");
+    EXPECT_TRUE(fs::exists(certDir + "/" + certs[0]->getSubjectNameHash() +
+                           ".0"));
+
+    // A copy of a known certificate gets no object and no ID
+    fs::copy_file(droppedFile, certDir + "/copy.pem");
+    runEventLoop(event, std::chrono::milliseconds(1000));
+    EXPECT_EQ(certs.size(), 1);
+
+    createNewCertificate(true);
+    fs::copy_file(certificateFile, certDir + "/other.pem");
+    runEventLoop(event, std::chrono::milliseconds(1000));
+    ASSERT_EQ(certs.size(), 2);
+    EXPECT_EQ(certs[1]->getObjectPath(), objPath + "/3");
+}
+
+/** @brief Check restored certificates match the cached metadata and that a
+ *  changed file is parsed again
+ */
+TEST_F(TestCertificates, TestMetadataCacheRestore)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    std::string verifyDir(certDir);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    std::string certFilePath;
+    std::string certId;
+    std::string subject;
+    std::string pem;
+    {
+        Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+        manager.install(certificateFile);
+        ASSERT_EQ(manager.getCertificates().size(), 1);
+        certFilePath = manager.getCertificates()[0]->getCertFilePath();
+        certId = manager.getCertificates()[0]->getCertId();
+        subject = manager.getCertificates()[0]->subject();
+        pem = manager.getCertificates()[0]->certificateString();
+    }
+    EXPECT_TRUE(fs::exists(verifyDir + "/.metadata"));
+
+    {
+        Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+        ASSERT_EQ(manager.getCertificates().size(), 1);
+        EXPECT_EQ(manager.getCertificates()[0]->getCertId(), certId);
+        EXPECT_EQ(manager.getCertificates()[0]->subject(), subject);
+        EXPECT_EQ(manager.getCertificates()[0]->certificateString(), pem);
+    }
+
+    createNewCertificate(true);
+    fs::copy_file(certificateFile, certFilePath,
+                  fs::copy_options::overwrite_existing);
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+    ASSERT_EQ(manager.getCertificates().size(), 1);
+    EXPECT_NE(manager.getCertificates()[0]->getCertId(), certId);
+}
+
+/** @brief Check a certificate restored from the metadata cache is announced
+ *  without its file being read again
+ */
+TEST_F(TestCertificates, TestAnnounceWithoutDecoding)
+{
+    std::string endpoint("ldap");
+    CertificateType type = CertificateType::Authority;
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    std::string certFileName;
+    {
+        Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+        manager.install(certificateFile);
+        ASSERT_EQ(manager.getCertificates().size(), 1);
+        certFileName =
+            fs::path(manager.getCertificates()[0]->getCertFilePath())
+                .filename();
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    ASSERT_GE(inotify_add_watch(fd, certDir.c_str(), IN_OPEN), 0);
+    Manager manager(bus, event, objPath.c_str(), type, "", certDir);
+    ASSERT_EQ(manager.getCertificates().size(), 1);
+
+    // The restore reads the file once to check it against the cache
+    int opened = 0;
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length = 0;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char* ptr = buffer; ptr < buffer + length;)
+        {
+            auto* e = reinterpret_cast<inotify_event*>(ptr);
+            if (e->len != 0 && certFileName == e->name)
+            {
+                opened++;
+            }
+            ptr += sizeof(inotify_event) + e->len;
+        }
+    }
+    close(fd);
+    EXPECT_EQ(opened, 1);
+}
+
 /** @brief Test verifiing if delete function works.
  */
 TEST_F(TestCertificates, TestStorageDeleteCertificate)
@@ -922,6 +1798,33 @@ TEST_F(TestInvalidCertificate, TestMissingCeritificate)
     EXPECT_FALSE(fs::exists(verifyPath));
 }
 
+/** @brief Check the system private key is appended to the installed
+ *  certificate without touching the uploaded file
+ */
+TEST_F(TestInvalidCertificate, TestAppendSystemPrivateKey)
+{
+    std::string endpoint("ldap");
+    std::string unit;
+    CertificateType type = CertificateType::Client;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyPath(installPath);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    fs::copy_file(keyFile, certDir + "/privkey.pem");
+    auto uploadSize = fs::file_size(certificateFile);
+    auto event = sdeventplus::Event::get_default();
+    // Attach the bus to sd_event to service user requests
+    bus.attach_event(event.get(), SD_EVENT_PRIORITY_NORMAL);
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(installPath));
+    MainApp mainApp(&manager);
+    mainApp.install(certificateFile);
+    EXPECT_TRUE(fs::exists(verifyPath));
+    EXPECT_EQ(fs::file_size(certificateFile), uploadSize);
+    EXPECT_EQ(fs::file_size(verifyPath),
+              uploadSize + 1 + fs::file_size(keyFile));
+}
+
 /** @brief Check if error is thrown when multiple certificates are installed
  *  At present only one certificate per service is allowed
  */
@@ -1018,8 +1921,8 @@ TEST_F(TestCertificates, TestGenerateCSR)
             }
         },
         InternalFailure);
-    // wait for 10 sec to get CSR and privateKey Files generated
-    sleep(10);
+    // wait for the CSR and privateKey Files to be generated
+    EXPECT_TRUE(waitForCSR(event, manager));
     EXPECT_TRUE(fs::exists(CSRPath));
     EXPECT_TRUE(fs::exists(privateKeyPath));
     csrData = csr.csr();
@@ -1069,7 +1972,7 @@ TEST_F(TestCertificates, TestGenerateCSRwithEmptyKeyPairAlgorithm)
                         keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
                         organization, organizationalUnit, state, surname,
                         unstructuredName);
-    sleep(10);
+    EXPECT_TRUE(waitForCSR(event, manager));
     EXPECT_TRUE(fs::exists(CSRPath));
     EXPECT_TRUE(fs::exists(privateKeyPath));
 }
@@ -1079,6 +1982,8 @@ TEST_F(TestCertificates, TestGenerateCSRwithEmptyKeyPairAlgorithm)
  */
 TEST_F(TestCertificates, TestGenerateCSRwithUnsupportedKeyPairAlgorithm)
 {
+    using InvalidArgument =
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
     std::string endpoint("https");
     std::string unit;
     CertificateType type = CertificateType::Server;
@@ -1112,11 +2017,14 @@ TEST_F(TestCertificates, TestGenerateCSRwithUnsupportedKeyPairAlgorithm)
     Status status;
     CSR csr(bus, objPath.c_str(), CSRPath.c_str(), status);
     MainApp mainApp(&manager, &csr);
-    mainApp.generateCSR(alternativeNames, challengePassword, city, commonName,
-                        contactPerson, country, email, givenName, initials,
-                        keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
-                        organization, organizationalUnit, state, surname,
-                        unstructuredName);
+    EXPECT_THROW(mainApp.generateCSR(
+                     alternativeNames, challengePassword, city, commonName,
+                     contactPerson, country, email, givenName, initials,
+                     keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
+                     organization, organizationalUnit, state, surname,
+                     unstructuredName),
+                 InvalidArgument);
+    EXPECT_EQ(manager.getCSR(), nullptr);
     EXPECT_FALSE(fs::exists(CSRPath));
     EXPECT_FALSE(fs::exists(privateKeyPath));
 }
@@ -1126,6 +2034,8 @@ TEST_F(TestCertificates, TestGenerateCSRwithUnsupportedKeyPairAlgorithm)
  */
 TEST_F(TestCertificates, TestECKeyGenerationwithNIDundefCase)
 {
+    using InvalidArgument =
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
     std::string endpoint("https");
     std::string unit;
     CertificateType type = CertificateType::Server;
@@ -1159,11 +2069,14 @@ TEST_F(TestCertificates, TestECKeyGenerationwithNIDundefCase)
     Status status;
     CSR csr(bus, objPath.c_str(), CSRPath.c_str(), status);
     MainApp mainApp(&manager, &csr);
-    mainApp.generateCSR(alternativeNames, challengePassword, city, commonName,
-                        contactPerson, country, email, givenName, initials,
-                        keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
-                        organization, organizationalUnit, state, surname,
-                        unstructuredName);
+    EXPECT_THROW(mainApp.generateCSR(
+                     alternativeNames, challengePassword, city, commonName,
+                     contactPerson, country, email, givenName, initials,
+                     keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
+                     organization, organizationalUnit, state, surname,
+                     unstructuredName),
+                 InvalidArgument);
+    EXPECT_EQ(manager.getCSR(), nullptr);
     EXPECT_FALSE(fs::exists(CSRPath));
     EXPECT_FALSE(fs::exists(privateKeyPath));
 }
@@ -1210,7 +2123,7 @@ TEST_F(TestCertificates, TestECKeyGenerationwithDefaultKeyCurveId)
                         keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
                         organization, organizationalUnit, state, surname,
                         unstructuredName);
-    sleep(10);
+    EXPECT_TRUE(waitForCSR(event, manager));
     EXPECT_TRUE(fs::exists(CSRPath));
     EXPECT_TRUE(fs::exists(privateKeyPath));
 }
@@ -1257,17 +2170,14 @@ TEST_F(TestCertificates, TestECKeyGeneration)
                         keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
                         organization, organizationalUnit, state, surname,
                         unstructuredName);
-    std::cout << "CSRPath: " << CSRPath << std::endl
-              << "privateKeyPath: " << privateKeyPath << std::endl;
-    sleep(10);
+    EXPECT_TRUE(waitForCSR(event, manager));
     EXPECT_TRUE(fs::exists(CSRPath));
     EXPECT_TRUE(fs::exists(privateKeyPath));
 }
 
-/** @brief Check error is thrown if giving unsupported key bit length to
- * generate rsa key
+/** @brief Check if error is not thrown to generate EdDSA key pair
  */
-TEST_F(TestCertificates, TestRSAKeyWithUnsupportedKeyBitLength)
+TEST_F(TestCertificates, TestEdDSAKeyGeneration)
 {
     std::string endpoint("https");
     std::string unit;
@@ -1285,9 +2195,9 @@ TEST_F(TestCertificates, TestRSAKeyWithUnsupportedKeyBitLength)
     std::string email("admin@in.ibm.com");
     std::string givenName("givenName");
     std::string initials("G");
-    int64_t keyBitLength(4096);
-    std::string keyCurveId("secp521r1");
-    std::string keyPairAlgorithm("RSA");
+    int64_t keyBitLength(2048);
+    std::string keyCurveId("Ed25519");
+    std::string keyPairAlgorithm("EdDSA");
     std::vector<std::string> keyUsage{"serverAuth", "clientAuth"};
     std::string organization("IBM");
     std::string organizationalUnit("orgUnit");
@@ -1307,13 +2217,136 @@ TEST_F(TestCertificates, TestRSAKeyWithUnsupportedKeyBitLength)
                         keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
                         organization, organizationalUnit, state, surname,
                         unstructuredName);
+    EXPECT_TRUE(waitForCSR(event, manager));
+    EXPECT_TRUE(fs::exists(CSRPath));
+    EXPECT_TRUE(fs::exists(privateKeyPath));
+}
+
+/** @brief Check error is thrown if giving unsupported key bit length to
+ * generate rsa key
+ */
+TEST_F(TestCertificates, TestRSAKeyWithUnsupportedKeyBitLength)
+{
+    using InvalidArgument =
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+    std::string endpoint("https");
+    std::string unit;
+    CertificateType type = CertificateType::Server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string verifyPath(installPath);
+    std::string CSRPath(certDir + "/" + CSRFile);
+    std::string privateKeyPath(certDir + "/" + privateKeyFile);
+    std::vector<std::string> alternativeNames{"localhost1", "localhost2"};
+    std::string challengePassword("Password");
+    std::string city("BLR");
+    std::string commonName("abc.com");
+    std::string contactPerson("Admin");
+    std::string country("IN");
+    std::string email("admin@in.ibm.com");
+    std::string givenName("givenName");
+    std::string initials("G");
+    int64_t keyBitLength(1024);
+    std::string keyCurveId("secp521r1");
+    std::string keyPairAlgorithm("RSA");
+    std::vector<std::string> keyUsage{"serverAuth", "clientAuth"};
+    std::string organization("IBM");
+    std::string organizationalUnit("orgUnit");
+    std::string state("TS");
+    std::string surname("surname");
+    std::string unstructuredName("unstructuredName");
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(installPath));
+    Status status;
+    CSR csr(bus, objPath.c_str(), CSRPath.c_str(), status);
+    MainApp mainApp(&manager, &csr);
+    EXPECT_THROW(mainApp.generateCSR(
+                     alternativeNames, challengePassword, city, commonName,
+                     contactPerson, country, email, givenName, initials,
+                     keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
+                     organization, organizationalUnit, state, surname,
+                     unstructuredName),
+                 InvalidArgument);
+    EXPECT_EQ(manager.getCSR(), nullptr);
     EXPECT_FALSE(fs::exists(CSRPath));
     EXPECT_FALSE(fs::exists(privateKeyPath));
 }
 
-/** @brief Check error is thrown if generated rsa key file is not present
+/** @brief Check a second CSR request queued behind the first one does not
+ *  lose either result, the CSR object reports the latest request
  */
-TEST_F(TestCertificates, TestRSAKeyFileNotPresentCase)
+TEST_F(TestCertificates, TestQueuedCSRRequests)
+{
+    std::string endpoint("https");
+    std::string unit;
+    CertificateType type = CertificateType::Server;
+    std::string installPath(certDir + "/" + certificateFile);
+    std::string CSRPath(certDir + "/" + CSRFile);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(installPath));
+    MainApp mainApp(&manager);
+    for (const char* commonName : {"first", "second"})
+    {
+        mainApp.generateCSR({}, "", "BLR", commonName, "", "IN", "", "", "",
+                            2048, "", "EC", {}, "IBM", "", "", "", "");
+    }
+    ASSERT_TRUE(waitForCSR(event, manager));
+
+    std::string csrData = readFile(CSRPath);
+    std::unique_ptr<BIO, decltype(&::BIO_free)> bio(
+        BIO_new_mem_buf(csrData.data(), static_cast<int>(csrData.size())),
+        ::BIO_free);
+    std::unique_ptr<X509_REQ, decltype(&::X509_REQ_free)> request(
+        PEM_read_bio_X509_REQ(bio.get(), nullptr, nullptr, nullptr),
+        ::X509_REQ_free);
+    ASSERT_NE(request, nullptr);
+    char commonName[64] = {};
+    X509_NAME_get_text_by_NID(X509_REQ_get_subject_name(request.get()),
+                              NID_commonName, commonName, sizeof(commonName));
+    EXPECT_STREQ(commonName, "second");
+}
+
+/** @brief Check CSR requests are rejected while too many are in progress
+ */
+TEST_F(TestCertificates, TestPendingCSRLimit)
+{
+    using NotAllowed =
+        sdbusplus::xyz::openbmc_project::Common::Error::NotAllowed;
+    std::string endpoint("https");
+    std::string unit;
+    CertificateType type = CertificateType::Server;
+    std::string installPath(certDir + "/" + certificateFile);
+    auto objPath = std::string(objectNamePrefix) + '/' +
+                   certificateTypeToString(type) + '/' + endpoint;
+    auto event = sdeventplus::Event::get_default();
+    Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
+                    std::move(installPath));
+    MainApp mainApp(&manager);
+    auto request = [&mainApp]() {
+        mainApp.generateCSR({}, "", "BLR", "abc.com", "", "IN", "", "", "",
+                            2048, "", "EC", {}, "IBM", "", "", "", "");
+    };
+
+    // Requests are only finished once the event loop runs
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_NO_THROW(request());
+    }
+    EXPECT_THROW(request(), NotAllowed);
+
+    ASSERT_TRUE(waitForCSR(event, manager));
+    EXPECT_NO_THROW(request());
+    EXPECT_TRUE(waitForCSR(event, manager));
+}
+
+/** @brief Check the rsa key is generated on demand if the key pool has none
+ */
+TEST_F(TestCertificates, TestRSAKeyPoolEmptyCase)
 {
     std::string endpoint("https");
     std::string unit;
@@ -1346,8 +2379,8 @@ TEST_F(TestCertificates, TestRSAKeyFileNotPresentCase)
     Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
                     std::move(installPath));
 
-    // Removing generated RSA key file
-    fs::remove(rsaPrivateKeyFilePath);
+    // Removing pre-generated keys
+    fs::remove_all(keyPoolPath);
 
     Status status;
     CSR csr(bus, objPath.c_str(), CSRPath.c_str(), status);
@@ -1357,8 +2390,9 @@ TEST_F(TestCertificates, TestRSAKeyFileNotPresentCase)
                         keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
                         organization, organizationalUnit, state, surname,
                         unstructuredName);
-    EXPECT_FALSE(fs::exists(CSRPath));
-    EXPECT_FALSE(fs::exists(privateKeyPath));
+    EXPECT_TRUE(waitForCSR(event, manager));
+    EXPECT_TRUE(fs::exists(CSRPath));
+    EXPECT_TRUE(fs::exists(privateKeyPath));
 }
 
 /** @brief Check private key file is created from generated rsa key file is
@@ -1404,12 +2438,14 @@ TEST_F(TestCertificates, TestRSAKeyFromRSAKeyFileIsWrittenIntoPrivateKeyFile)
                         keyBitLength, keyCurveId, keyPairAlgorithm, keyUsage,
                         organization, organizationalUnit, state, surname,
                         unstructuredName);
-    sleep(10);
+    EXPECT_TRUE(waitForCSR(event, manager));
     EXPECT_TRUE(fs::exists(CSRPath));
     EXPECT_TRUE(fs::exists(privateKeyPath));
 }
 
-/** @brief Check RSA key is generated during application startup*/
+/** @brief Check RSA key is generated into the key pool in the background
+ * after application startup and the key file of earlier versions is dropped
+ */
 TEST_F(TestCertificates, TestGenerateRSAPrivateKeyFile)
 {
     std::string endpoint("https");
@@ -1420,10 +2456,93 @@ TEST_F(TestCertificates, TestGenerateRSAPrivateKeyFile)
                    certificateTypeToString(type) + '/' + endpoint;
     auto event = sdeventplus::Event::get_default();
 
-    EXPECT_FALSE(fs::exists(rsaPrivateKeyFilePath));
+    std::ofstream(rsaPrivateKeyFilePath) << "stale";
+    EXPECT_FALSE(fs::exists(keyPoolPath));
     Manager manager(bus, event, objPath.c_str(), type, std::move(unit),
                     std::move(installPath));
-    EXPECT_TRUE(fs::exists(rsaPrivateKeyFilePath));
+    EXPECT_FALSE(fs::exists(rsaPrivateKeyFilePath));
+    EXPECT_TRUE(runEventLoop(event, std::chrono::seconds(10), [this]() {
+        return !fs::is_empty(keyPoolPath);
+    }));
+}
+
+/** @brief Check pooled keys are refilled, handed out once and kept across
+ * restarts
+ */
+TEST_F(TestCertificates, TestKeyPool)
+{
+    auto generate = [](const KeySpec&) {
+        KeyPool::KeyPtr key(nullptr, ::EVP_PKEY_free);
+        std::unique_ptr<EVP_PKEY_CTX, decltype(&::EVP_PKEY_CTX_free)> ctx(
+            EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), ::EVP_PKEY_CTX_free);
+        EVP_PKEY* raw = nullptr;
+        if (ctx && EVP_PKEY_keygen_init(ctx.get()) > 0 &&
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(
+                ctx.get(), NID_X9_62_prime256v1) > 0 &&
+            EVP_PKEY_keygen(ctx.get(), &raw) > 0)
+        {
+            key.reset(raw);
+        }
+        return key;
+    };
+    KeySpec spec{"EC", "prime256v1"};
+    std::string poolPath = certDir + "/pool";
+    auto event = sdeventplus::Event::get_default();
+    {
+        KeyPool keyPool(poolPath, 2, generate);
+        EXPECT_FALSE(keyPool.take(spec));
+        keyPool.keep(spec);
+        runEventLoop(event, std::chrono::seconds(10),
+                     [&keyPool, &spec]() { return keyPool.ready(spec) == 2; });
+        EXPECT_EQ(keyPool.ready(spec), 2);
+        EXPECT_TRUE(keyPool.take(spec));
+    }
+
+    // Whatever is left is picked up again, nothing is handed out twice.
+    KeyPool keyPool(poolPath, 0, generate);
+    size_t ready = keyPool.ready(spec);
+    EXPECT_GE(ready, 1);
+    for (size_t i = 0; i < ready; ++i)
+    {
+        EXPECT_TRUE(keyPool.take(spec));
+    }
+    EXPECT_FALSE(keyPool.take(spec));
+    EXPECT_TRUE(fs::is_empty(poolPath));
+}
+
+/** @brief Check pooled keys of curves with dashes in their name are picked
+ *  up again and files that do not parse are removed
+ */
+TEST_F(TestCertificates, TestKeyPoolCurveNames)
+{
+    auto generate = [](const KeySpec&) {
+        KeyPool::KeyPtr key(nullptr, ::EVP_PKEY_free);
+        std::unique_ptr<EVP_PKEY_CTX, decltype(&::EVP_PKEY_CTX_free)> ctx(
+            EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), ::EVP_PKEY_CTX_free);
+        EVP_PKEY* raw = nullptr;
+        if (ctx && EVP_PKEY_keygen_init(ctx.get()) > 0 &&
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(
+                ctx.get(), NID_X9_62_prime256v1) > 0 &&
+            EVP_PKEY_keygen(ctx.get(), &raw) > 0)
+        {
+            key.reset(raw);
+        }
+        return key;
+    };
+    KeySpec spec{"EC", "wap-wsg-idm-ecid-wtls8"};
+    std::string poolPath = certDir + "/pool";
+    {
+        KeyPool keyPool(poolPath, 0, generate);
+        auto key = generate(spec);
+        ASSERT_TRUE(key);
+        keyPool.add(spec, *key);
+    }
+    std::ofstream(poolPath + "/EC.pem") << "stray\n";
+
+    KeyPool keyPool(poolPath, 0, generate);
+    EXPECT_EQ(keyPool.ready(spec), 1);
+    EXPECT_TRUE(keyPool.take(spec));
+    EXPECT_TRUE(fs::is_empty(poolPath));
 }
 } // namespace
 } // namespace phosphor::certs
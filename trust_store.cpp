@@ -0,0 +1,105 @@
+#include "trust_store.hpp"
+
+#include <openssl/err.h>
+
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+
+/** @brief Remove a certificate from the object cache of the store */
+void removeObject(X509_STORE* store, const X509* cert)
+{
+    X509_STORE_lock(store);
+    STACK_OF(X509_OBJECT)* objects = X509_STORE_get0_objects(store);
+    for (int i = 0; i < sk_X509_OBJECT_num(objects); ++i)
+    {
+        X509_OBJECT* object = sk_X509_OBJECT_value(objects, i);
+        if (X509_OBJECT_get_type(object) == X509_LU_X509 &&
+            X509_OBJECT_get0_X509(object) == cert)
+        {
+            sk_X509_OBJECT_delete(objects, i);
+            X509_OBJECT_free(object);
+            break;
+        }
+    }
+    X509_STORE_unlock(store);
+}
+} // namespace
+
+TrustStore::TrustStore() : store(X509_STORE_new(), ::X509_STORE_free)
+{
+    if (!store)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_new call");
+        elog<InternalFailure>();
+    }
+}
+
+bool TrustStore::contains(const std::string& digest) const
+{
+    return anchors.contains(digest);
+}
+
+void TrustStore::add(X509& cert)
+{
+    std::string digest = generateCertDigest(cert);
+    if (anchors.contains(digest))
+    {
+        return;
+    }
+    if (X509_STORE_add_cert(store.get(), &cert) != 1)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_add_cert call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+    X509_up_ref(&cert);
+    anchors.emplace(std::move(digest), internal::X509Ptr(&cert, ::X509_free));
+}
+
+void TrustStore::retain(const std::unordered_set<std::string>& digests)
+{
+    for (auto it = anchors.begin(); it != anchors.end();)
+    {
+        if (digests.contains(it->first))
+        {
+            ++it;
+            continue;
+        }
+        removeObject(store.get(), it->second.get());
+        it = anchors.erase(it);
+    }
+}
+
+void TrustStore::addDirectory(const std::string& directory)
+{
+    X509_LOOKUP* lookup =
+        X509_STORE_add_lookup(store.get(), X509_LOOKUP_hash_dir());
+    if (lookup == nullptr ||
+        X509_LOOKUP_add_dir(lookup, directory.c_str(), X509_FILETYPE_PEM) != 1)
+    {
+        log<level::ERR>("Failed to add trust anchor directory",
+                        entry("DIRECTORY=%s", directory.c_str()),
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+}
+
+X509_STORE* TrustStore::get() const
+{
+    return store.get();
+}
+
+} // namespace phosphor::certs
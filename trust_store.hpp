@@ -0,0 +1,69 @@
+#pragma once
+
+#include "x509_utils.hpp"
+
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace phosphor::certs
+{
+
+/** @class TrustStore
+ *  @brief Long-lived OpenSSL store of trust anchors.
+ *  @details Anchors are either added one by one and tracked by the SHA-256
+ *  digest of the certificate, so that they can be dropped again without
+ *  rebuilding the store, or looked up on demand in an OpenSSL hash
+ *  directory.
+ */
+class TrustStore
+{
+  public:
+    TrustStore(const TrustStore&) = delete;
+    TrustStore& operator=(const TrustStore&) = delete;
+    TrustStore(TrustStore&&) = delete;
+    TrustStore& operator=(TrustStore&&) = delete;
+    ~TrustStore() = default;
+
+    /** @brief Constructor, creates an empty store. */
+    TrustStore();
+
+    /** @brief Check whether an anchor is in the store.
+     *  @param[in] digest - SHA-256 digest of the certificate.
+     *  @return True if the anchor was added.
+     */
+    bool contains(const std::string& digest) const;
+
+    /** @brief Add an anchor.
+     *  @param[in] cert - Anchor certificate.
+     */
+    void add(X509& cert);
+
+    /** @brief Drop the anchors that are not listed.
+     *  @param[in] digests - SHA-256 digests of the anchors to keep.
+     */
+    void retain(const std::unordered_set<std::string>& digests);
+
+    /** @brief Look up anchors in a directory with OpenSSL hash links.
+     *  @param[in] directory - Anchor directory.
+     */
+    void addDirectory(const std::string& directory);
+
+    /** @brief Get the OpenSSL store.
+     *  @return Store for verification.
+     */
+    X509_STORE* get() const;
+
+  private:
+    /** @brief OpenSSL store */
+    std::unique_ptr<X509_STORE, decltype(&::X509_STORE_free)> store;
+
+    /** @brief Anchors added to the store by digest */
+    std::unordered_map<std::string, internal::X509Ptr> anchors;
+};
+
+} // namespace phosphor::certs
@@ -2,18 +2,22 @@
 
 #include <sys/epoll.h>
 #include <sys/inotify.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
-#include <climits>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
+#include <iterator>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdeventplus/source/io.hpp>
+#include <utility>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 namespace phosphor::certs
@@ -26,11 +30,23 @@ using ::phosphor::logging::log;
 using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 namespace fs = std::filesystem;
 
-Watch::Watch(sdeventplus::Event& event, std::string& certFile, Callback cb) :
-    event(event), callback(std::move(cb))
+namespace
+{
+// Writers that close the file after every chunk cause several events,
+// the callback runs once the file has been left alone this long.
+constexpr std::chrono::milliseconds settleWindow(100);
+// A file rewritten continuously is still picked up this often.
+constexpr std::chrono::milliseconds settleMaxDelay(1000);
+} // namespace
+
+Watch::Watch(sdeventplus::Event& event, std::string& certFile, Callback cb,
+             bool directory) :
+    event(event),
+    callback(std::move(cb)), settleTimer(event, [this](Timer&) { settled(); })
 {
     // get parent directory of certificate file to watch
-    fs::path path = fs::path(certFile).parent_path();
+    fs::path path = directory ? fs::path(certFile)
+                              : fs::path(certFile).parent_path();
     try
     {
         if (!fs::exists(path))
@@ -45,7 +61,10 @@ Watch::Watch(sdeventplus::Event& event, std::string& certFile, Callback cb) :
         elog<InternalFailure>();
     }
     watchDir = path;
-    watchFile = fs::path(certFile).filename();
+    if (!directory)
+    {
+        watchFile = fs::path(certFile).filename();
+    }
     startWatch();
 }
 
@@ -66,10 +85,14 @@ void Watch::startWatch()
                         entry("ERR=%s", std::strerror(errno)));
         elog<InternalFailure>();
     }
-    wd = inotify_add_watch(fd, watchDir.c_str(), IN_CLOSE_WRITE);
+    // Files linked into the directory, e.g. with ln, are only created
+    wd = inotify_add_watch(fd, watchDir.c_str(),
+                           IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO |
+                               IN_DELETE | IN_MOVED_FROM);
     if (-1 == wd)
     {
         close(fd);
+        fd = -1;
         log<level::ERR>("inotify_add_watch failed,",
                         entry("ERR=%s", std::strerror(errno)),
                         entry("WATCH=%s", watchDir.c_str()));
@@ -77,31 +100,171 @@ void Watch::startWatch()
     }
 
     ioPtr = std::make_unique<sdeventplus::source::IO>(
-        event, fd, EPOLLIN, [this](sdeventplus::source::IO&, int fd, uint32_t) {
-            constexpr int size = sizeof(struct inotify_event) + NAME_MAX + 1;
-            std::array<char, size> buffer{};
-            int length = read(fd, buffer.data(), buffer.size());
-            if (length >= static_cast<int>(sizeof(struct inotify_event)))
+        event, fd, EPOLLIN,
+        [this](sdeventplus::source::IO&, int, uint32_t) { readEvents(); });
+}
+
+void Watch::readEvents()
+{
+    // Every read returns as many whole events as fit into the buffer, the
+    // descriptor is drained so that none is left for the next wakeup.
+    alignas(struct inotify_event) std::array<char, 4096> buffer;
+    bool changed = false;
+    while (true)
+    {
+        ssize_t length = read(fd, buffer.data(), buffer.size());
+        if (length <= 0)
+        {
+            if (length < 0 && errno != EAGAIN)
             {
-                struct inotify_event* notifyEvent =
-                    reinterpret_cast<struct inotify_event*>(&buffer[0]);
-                if (notifyEvent->len)
-                {
-                    if (watchFile == notifyEvent->name)
-                    {
-                        callback();
-                    }
-                }
+                log<level::ERR>("Failed to read inotify event",
+                                entry("ERR=%s", std::strerror(errno)));
             }
-            else
+            break;
+        }
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* notifyEvent =
+                reinterpret_cast<const struct inotify_event*>(&buffer[offset]);
+            // Events were lost, any file may have changed among them.
+            // Hidden files of a directory are temporaries and the metadata
+            // cache.
+            if (notifyEvent->mask & IN_Q_OVERFLOW)
+            {
+                eventsLost = true;
+                changed = true;
+            }
+            else if (notifyEvent->len &&
+                     (watchFile.empty() ? notifyEvent->name[0] != '.'
+                                        : watchFile == notifyEvent->name))
             {
-                log<level::ERR>("Failed to read inotify event");
+                changedFiles.insert(notifyEvent->name);
+                changed = true;
             }
-        });
+            offset += sizeof(struct inotify_event) + notifyEvent->len;
+        }
+    }
+    // Changes seen while suppressed are passed on once it ends
+    if (changed && suppressions == 0)
+    {
+        schedule();
+    }
+}
+
+void Watch::schedule()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (!settleTimer.isEnabled())
+    {
+        firstChange = now;
+    }
+    auto delay = std::min<std::chrono::steady_clock::duration>(
+        settleWindow, firstChange + settleMaxDelay - now);
+    delay = std::max<std::chrono::steady_clock::duration>(
+        delay, std::chrono::steady_clock::duration::zero());
+    settleTimer.restartOnce(std::chrono::duration_cast<Timer::Duration>(delay));
+}
+
+void Watch::settled()
+{
+    settleTimer.setEnabled(false);
+    if (suppressions != 0)
+    {
+        return;
+    }
+
+    // Events of the service's own changes may arrive after the suppression
+    // ended, the file tells whether anybody else changed it since. The
+    // events of a change settle together, its entry is dropped with them.
+    for (auto it = changedFiles.begin(); it != changedFiles.end();)
+    {
+        auto own = ownWrites.find(*it);
+        if (own == ownWrites.end())
+        {
+            ++it;
+            continue;
+        }
+        const bool unchanged = fileState(*it) == own->second;
+        ownWrites.erase(own);
+        it = unchanged ? changedFiles.erase(it) : std::next(it);
+    }
+
+    std::set<std::string> files = std::exchange(changedFiles, {});
+    if (std::exchange(eventsLost, false))
+    {
+        files.clear();
+        if (!watchFile.empty())
+        {
+            files.insert(watchFile);
+        }
+    }
+    else if (files.empty())
+    {
+        return;
+    }
+    callback(files);
+}
+
+std::optional<Watch::FileState>
+    Watch::fileState(const std::string& name) const
+{
+    struct stat st = {};
+    const std::string path = watchDir + '/' + name;
+    if (lstat(path.c_str(), &st) < 0)
+    {
+        return std::nullopt;
+    }
+    return FileState{static_cast<uint64_t>(st.st_ino),
+                     static_cast<uint64_t>(st.st_size),
+                     static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                         st.st_mtim.tv_nsec};
+}
+
+void Watch::release()
+{
+    if (--suppressions != 0)
+    {
+        return;
+    }
+    if (!changedFiles.empty() || eventsLost)
+    {
+        schedule();
+    }
+}
+
+Watch::Suppression::Suppression(Watch* watch) : watch(watch)
+{
+    if (watch)
+    {
+        watch->suppressions++;
+    }
+}
+
+Watch::Suppression::~Suppression()
+{
+    if (watch)
+    {
+        watch->release();
+    }
+}
+
+void Watch::Suppression::written(const std::string& filePath)
+{
+    if (!watch)
+    {
+        return;
+    }
+    const std::string name = fs::path(filePath).filename();
+    watch->ownWrites[name] = watch->fileState(name);
 }
 
 void Watch::stopWatch()
 {
+    settleTimer.setEnabled(false);
+    if (ioPtr)
+    {
+        ioPtr.reset();
+    }
     if (-1 != fd)
     {
         if (-1 != wd)
@@ -110,10 +273,8 @@ void Watch::stopWatch()
         }
         close(fd);
     }
-    if (ioPtr)
-    {
-        ioPtr.reset();
-    }
+    wd = -1;
+    fd = -1;
 }
 
 } // namespace phosphor::certs
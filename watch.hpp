@@ -1,8 +1,15 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
+#include <optional>
+#include <sdeventplus/clock.hpp>
 #include <sdeventplus/source/event.hpp>
 #include <sdeventplus/source/io.hpp>
+#include <sdeventplus/utility/timer.hpp>
+#include <set>
 #include <string>
 
 namespace phosphor::certs
@@ -13,18 +20,32 @@ namespace phosphor::certs
  *
  *  The inotify watch is hooked up with sd-event, so that on call back,
  *  appropriate actions related to a certificate upload can be taken.
+ *  Files written in place and files renamed over the certificate file are
+ *  both seen, as are created, linked and deleted files. A burst of changes
+ *  results in a single callback once the files have not changed for a
+ *  short while, it is passed the names of the changed files. Writes of the
+ *  service itself are made under a Suppression and do not call back.
  */
 class Watch
 {
   public:
-    using Callback = std::function<void()>;
+    /** @brief Called with the names of the files changed since the last
+     *  call. The set is empty for a directory if events were lost, any file
+     *  of it may have changed then.
+     */
+    using Callback = std::function<void(const std::set<std::string>& files)>;
     /** @brief ctor - hook inotify watch with sd-event
      *
      *  @param[in] loop - sd-event object
+     *  @param[in] certFile - Certificate file, or directory if whole
+     *      directory is set
      *  @param[in] cb - The callback function for processing
      *                             certificate upload
+     *  @param[in] directory - Watch every file of the directory except
+     *      hidden ones
      */
-    Watch(sdeventplus::Event& event, std::string& certFile, Callback cb);
+    Watch(sdeventplus::Event& event, std::string& certFile, Callback cb,
+          bool directory = false);
     Watch(const Watch&) = delete;
     Watch& operator=(const Watch&) = delete;
     Watch(Watch&&) = delete;
@@ -34,6 +55,46 @@ class Watch
      */
     ~Watch();
 
+    /** @class Suppression
+     *  @brief Holds back callbacks while the service writes certificate
+     *  files. Changes seen meanwhile call back once it is gone, except for
+     *  files that still hold what the service wrote.
+     */
+    class Suppression
+    {
+      public:
+        /** @brief Constructor
+         *  @param[in] watch - Watch to suppress, may be null.
+         */
+        explicit Suppression(Watch* watch);
+        Suppression(const Suppression&) = delete;
+        Suppression& operator=(const Suppression&) = delete;
+        Suppression(Suppression&&) = delete;
+        Suppression& operator=(Suppression&&) = delete;
+        ~Suppression();
+
+        /** @brief Remember the file as just written, linked or removed by
+         *  the service, its events are ignored even if they arrive later.
+         *  @param[in] filePath - Path of the changed file.
+         */
+        void written(const std::string& filePath);
+
+      private:
+        /** @brief Suppressed watch */
+        Watch* watch;
+    };
+
+  private:
+    /** @brief Identity of the certificate file content */
+    struct FileState
+    {
+        uint64_t inode = 0;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+
+        bool operator==(const FileState&) const = default;
+    };
+
     /** @brief start watch on the specified path
      */
     void startWatch();
@@ -42,7 +103,27 @@ class Watch
      */
     void stopWatch();
 
-  private:
+    /** @brief End a suppression and pass on changes queued meanwhile */
+    void release();
+
+    /** @brief Current state of a file of the directory, if it exists.
+     *  Symbolic links are not followed. */
+    std::optional<FileState> fileState(const std::string& name) const;
+
+    /** @brief Call back with the changed files, leaving out those that are
+     *  as the service left them */
+    void settled();
+
+    using Timer = sdeventplus::utility::Timer<sdeventplus::ClockId::Monotonic>;
+
+    /** @brief Read all queued inotify events and schedule the callback if
+     *  any of them is about a certificate file
+     */
+    void readEvents();
+
+    /** @brief Restart the quiet window of the pending callback */
+    void schedule();
+
     /** @brief certificate upload directory watch descriptor */
     int wd = -1;
 
@@ -58,13 +139,29 @@ class Watch
     /** @brief callback method to be called */
     Callback callback;
 
+    /** @brief Expires when the certificate file has settled */
+    Timer settleTimer;
+
+    /** @brief Time of the first change since the last callback */
+    std::chrono::steady_clock::time_point firstChange;
+
+    /** @brief Number of active suppressions */
+    unsigned suppressions = 0;
+
+    /** @brief Names of the files changed since the last callback */
+    std::set<std::string> changedFiles;
+
+    /** @brief Set if events were lost since the last callback */
+    bool eventsLost = false;
+
+    /** @brief Files as last left by the service, by name, no state if
+     *  it removed them */
+    std::map<std::string, std::optional<FileState>> ownWrites;
+
     /** @brief Certificate directory to watch */
     std::string watchDir;
 
-    /** @brief Certificate file to watch */
+    /** @brief Certificate file to watch, empty for the whole directory */
     std::string watchFile;
-
-    /** @brief Certificate file with path */
-    std::string certFile;
 };
 } // namespace phosphor::certs
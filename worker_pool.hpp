@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+/** @class WorkerPool
+ *  @brief Fixed size pool of threads running CPU heavy certificate work.
+ *  @details Jobs must not touch D-Bus objects or the event loop, results are
+ *  handed back through the returned future and applied by the caller on the
+ *  event loop thread.
+ */
+class WorkerPool
+{
+  public:
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+
+    /** @brief Constructor, starts the worker threads.
+     *  @param[in] threads - Number of threads, 0 selects one per CPU.
+     */
+    explicit WorkerPool(size_t threads = 0);
+
+    /** @brief Destructor, finishes queued jobs and joins the threads. */
+    ~WorkerPool();
+
+    /** @brief Queue a job.
+     *  @param[in] job - Callable to run on a worker thread.
+     *  @return Future holding the job result or the exception it threw.
+     */
+    template <typename Job>
+    auto submit(Job&& job) -> std::future<std::invoke_result_t<Job>>
+    {
+        using Result = std::invoke_result_t<Job>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Job>(job));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.emplace_back([task]() { (*task)(); });
+        }
+        condition.notify_one();
+        return future;
+    }
+
+    /** @brief Number of worker threads. */
+    size_t size() const;
+
+  private:
+    /** @brief Worker thread main loop */
+    void run();
+
+    /** @brief Protects the queue and the stopping flag */
+    std::mutex mutex;
+
+    /** @brief Signals queued jobs and shutdown */
+    std::condition_variable condition;
+
+    /** @brief Jobs waiting for a worker */
+    std::deque<std::function<void()>> queue;
+
+    /** @brief Set when the pool is being destroyed */
+    bool stopping = false;
+
+    /** @brief Worker threads */
+    std::vector<std::thread> workers;
+};
+
+} // namespace phosphor::certs
@@ -0,0 +1,616 @@
+#include "x509_utils.hpp"
+
+#include "crypto_context.hpp"
+
+#include <fcntl.h>
+#include <openssl/asn1.h>
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/opensslv.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509_vfy.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <phosphor-logging/elog-errors.hpp>
+#include <phosphor-logging/elog.hpp>
+#include <phosphor-logging/log.hpp>
+#include <utility>
+#include <xyz/openbmc_project/Certs/error.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+namespace phosphor::certs
+{
+
+namespace
+{
+using ::phosphor::logging::elog;
+using ::phosphor::logging::entry;
+using ::phosphor::logging::level;
+using ::phosphor::logging::log;
+using InvalidCertificateError =
+    ::sdbusplus::xyz::openbmc_project::Certs::Error::InvalidCertificate;
+using ::phosphor::logging::xyz::openbmc_project::Certs::InvalidCertificate;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
+using ::sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument;
+using Argument =
+    ::phosphor::logging::xyz::openbmc_project::Common::InvalidArgument;
+
+// RAII support for openSSL functions.
+using BIOMemPtr = std::unique_ptr<BIO, decltype(&::BIO_free)>;
+using X509StorePtr = std::unique_ptr<X509_STORE, decltype(&::X509_STORE_free)>;
+using X509StoreCtxPtr =
+    std::unique_ptr<X509_STORE_CTX, decltype(&::X509_STORE_CTX_free)>;
+using ASN1TimePtr = std::unique_ptr<ASN1_TIME, decltype(&ASN1_STRING_free)>;
+using SSLPtr = std::unique_ptr<SSL, decltype(&::SSL_free)>;
+
+// Trust chain related errors.`
+#define TRUST_CHAIN_ERR(errnum)                                                \
+    ((errnum == X509_V_ERR_DEPTH_ZERO_SELF_SIGNED_CERT) ||                     \
+     (errnum == X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN) ||                       \
+     (errnum == X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY) ||               \
+     (errnum == X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT) ||                       \
+     (errnum == X509_V_ERR_CERT_UNTRUSTED) ||                                  \
+     (errnum == X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE))
+
+using X509StackPtr = std::unique_ptr<STACK_OF(X509), void (*)(STACK_OF(X509)*)>;
+
+void freeX509Stack(STACK_OF(X509)* stack)
+{
+    sk_X509_free(stack);
+}
+
+/** @brief Keep verifying past trust chain errors, so that the remaining
+ *  checks, e.g. validity and signatures, are still performed.
+ */
+int tolerateTrustChain(int ok, X509_STORE_CTX* ctx)
+{
+    if (ok == 0 && TRUST_CHAIN_ERR(X509_STORE_CTX_get_error(ctx)))
+    {
+        return 1;
+    }
+    return ok;
+}
+
+class FileDescriptor
+{
+  public:
+    explicit FileDescriptor(int fd) : fd(fd)
+    {
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor()
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+    int operator()() const
+    {
+        return fd;
+    }
+
+  private:
+    int fd;
+};
+
+// Uploads are small, a descriptor is not read beyond this size.
+constexpr size_t maxDescriptorDataSize = 1024 * 1024;
+
+// A client must not be able to change the upload while it is being read.
+constexpr int requiredSeals = F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW;
+
+/** @brief Read everything the descriptor provides. Regular files, memfds
+ *  included, are read from the start regardless of the file offset.
+ *  @param[in] fd - Descriptor to read.
+ *  @param[in] name - Data source name for logging.
+ *  @param[in] limit - Maximum data size accepted.
+ *  @return Data read.
+ */
+std::string readAll(int fd, const char* name, size_t limit)
+{
+    struct stat st = {};
+    if (fstat(fd, &st) < 0)
+    {
+        log<level::ERR>("Failed to stat file",
+                        entry("ERR=%s", std::strerror(errno)),
+                        entry("FILE=%s", name));
+        elog<InternalFailure>();
+    }
+    const bool positional = S_ISREG(st.st_mode);
+
+    // Size the buffer once and read the file in a single pass. Keep reading
+    // until EOF in case the file grows behind our back.
+    std::string data(
+        positional ? std::min(static_cast<size_t>(st.st_size), limit) : 0,
+        '\0');
+    size_t length = 0;
+    while (true)
+    {
+        if (length == data.size())
+        {
+            if (length >= limit)
+            {
+                char probe = 0;
+                ssize_t rc = positional
+                                 ? pread(fd, &probe, 1,
+                                         static_cast<off_t>(length))
+                                 : read(fd, &probe, 1);
+                if (rc == 0)
+                {
+                    break;
+                }
+                log<level::ERR>("Certificate data is too large",
+                                entry("FILE=%s", name));
+                elog<InvalidCertificateError>(
+                    InvalidCertificate::REASON("File is too large"));
+            }
+            data.resize(std::min(data.size() + BUFSIZ, limit));
+        }
+        ssize_t rc =
+            positional
+                ? pread(fd, data.data() + length, data.size() - length,
+                        static_cast<off_t>(length))
+                : read(fd, data.data() + length, data.size() - length);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            log<level::ERR>("Failed to read file",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("FILE=%s", name));
+            elog<InternalFailure>();
+        }
+        if (rc == 0)
+        {
+            break;
+        }
+        length += static_cast<size_t>(rc);
+    }
+    data.resize(length);
+    return data;
+}
+} // namespace
+
+std::string readFile(const std::string& filePath)
+{
+    FileDescriptor fd(open(filePath.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd() < 0)
+    {
+        if (errno == ENOENT)
+        {
+            log<level::ERR>("File is Missing",
+                            entry("FILE=%s", filePath.c_str()));
+        }
+        else
+        {
+            log<level::ERR>("Failed to open file",
+                            entry("ERR=%s", std::strerror(errno)),
+                            entry("FILE=%s", filePath.c_str()));
+        }
+        elog<InternalFailure>();
+    }
+
+    return readAll(fd(), filePath.c_str(), SIZE_MAX);
+}
+
+std::string readFileDescriptor(int fd)
+{
+    // Pipes, FIFOs and sockets could block the reader for as long as the
+    // client keeps them open, only sealed memfds are accepted.
+    struct stat st = {};
+    if (fstat(fd, &st) < 0)
+    {
+        log<level::ERR>("Failed to stat descriptor",
+                        entry("ERR=%s", std::strerror(errno)));
+        elog<InternalFailure>();
+    }
+    int seals = S_ISREG(st.st_mode) ? fcntl(fd, F_GET_SEALS) : -1;
+    if (seals < 0 || (seals & requiredSeals) != requiredSeals)
+    {
+        log<level::ERR>("Descriptor is not a sealed memfd",
+                        entry("MODE=0%o", st.st_mode));
+        elog<InvalidArgument>(Argument::ARGUMENT_NAME("FD"),
+                              Argument::ARGUMENT_VALUE("Not a sealed memfd"));
+    }
+    return readAll(fd, "descriptor", maxDescriptorDataSize);
+}
+
+std::function<std::string()> fileDescriptorReader(int fd)
+{
+    // The descriptor of the message is closed with it, the job outlives
+    // the message handler.
+    int copy = fcntl(fd, F_DUPFD_CLOEXEC, 3);
+    if (copy < 0)
+    {
+        log<level::ERR>("Failed to duplicate descriptor",
+                        entry("ERR=%s", std::strerror(errno)));
+        elog<InternalFailure>();
+    }
+    auto owned = std::make_shared<FileDescriptor>(copy);
+    return [owned]() { return readFileDescriptor((*owned)()); };
+}
+
+CertificateContent parseCertificate(std::string&& pem,
+                                    const std::string& sourcePath)
+{
+    if (pem.empty())
+    {
+        log<level::ERR>("File is empty", entry("FILE=%s", sourcePath.c_str()));
+        elog<InvalidCertificateError>(
+            InvalidCertificate::REASON("File is empty"));
+    }
+
+    CertificateContent content;
+    content.sourcePath = sourcePath;
+    content.pem = std::move(pem);
+
+    // Both BIOs are read only views of the buffer, nothing is copied.
+    BIOMemPtr certBio(BIO_new_mem_buf(content.pem.data(),
+                                      static_cast<int>(content.pem.size())),
+                      ::BIO_free);
+    BIOMemPtr keyBio(BIO_new_mem_buf(content.pem.data(),
+                                     static_cast<int>(content.pem.size())),
+                     ::BIO_free);
+    if (!certBio || !keyBio)
+    {
+        log<level::ERR>("Error occurred during BIO_new_mem_buf call",
+                        entry("FILE=%s", sourcePath.c_str()));
+        elog<InternalFailure>();
+    }
+
+    while (X509* x509 = PEM_read_bio_X509(certBio.get(), nullptr, nullptr,
+                                          nullptr))
+    {
+        if (!content.cert)
+        {
+            content.cert.reset(x509);
+        }
+        else
+        {
+            content.chain.emplace_back(x509, ::X509_free);
+        }
+    }
+    if (!content.cert)
+    {
+        log<level::ERR>("Error occurred during PEM_read_bio_X509 call",
+                        entry("FILE=%s", sourcePath.c_str()));
+        ERR_clear_error();
+        elog<InvalidCertificateError>(
+            InvalidCertificate::REASON("Invalid certificate file format"));
+    }
+
+    // A missing private key is not an error at this stage, the type specific
+    // install handlers decide what to do about it.
+    content.privateKey.reset(
+        PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr));
+
+    // Reaching the end of the PEM data leaves "no start line" on the queue.
+    ERR_clear_error();
+    return content;
+}
+
+std::vector<CertificateContent> splitBundle(const CertificateContent& bundle)
+{
+    std::vector<X509*> certs;
+    certs.reserve(bundle.chain.size() + 1);
+    certs.push_back(bundle.cert.get());
+    for (const auto& cert : bundle.chain)
+    {
+        certs.push_back(cert.get());
+    }
+
+    std::vector<CertificateContent> entries(certs.size());
+    for (size_t i = 0; i < certs.size(); ++i)
+    {
+        // No source path, every entry is written to a file of its own even
+        // if the bundle is in the install directory
+        CertificateContent& content = entries[i];
+
+        BIOMemPtr bio(BIO_new(BIO_s_mem()), ::BIO_free);
+        if (!bio || PEM_write_bio_X509(bio.get(), certs[i]) != 1)
+        {
+            log<level::ERR>("Error occurred during PEM_write_bio_X509 call",
+                            entry("FILE=%s", bundle.sourcePath.c_str()));
+            elog<InternalFailure>();
+        }
+        char* data = nullptr;
+        long size = BIO_get_mem_data(bio.get(), &data);
+        content.pem.assign(data, static_cast<size_t>(size));
+
+        X509_up_ref(certs[i]);
+        content.cert.reset(certs[i]);
+        for (size_t j = 0; j < certs.size(); ++j)
+        {
+            if (j != i)
+            {
+                X509_up_ref(certs[j]);
+                content.chain.emplace_back(certs[j], ::X509_free);
+            }
+        }
+    }
+    return entries;
+}
+
+CertificateContent loadCertificate(const std::string& filePath)
+{
+    return parseCertificate(readFile(filePath), filePath);
+}
+
+void validateCertificate(const CertificateContent& content,
+                         X509_STORE* anchors, bool requireAnchor)
+{
+    const char* file = content.sourcePath.c_str();
+    auto errCode = X509_V_OK;
+
+    X509StorePtr uploadStore(nullptr, &X509_STORE_free);
+    X509StackPtr untrusted(nullptr, freeX509Stack);
+    if (anchors == nullptr)
+    {
+        // Create an empty X509_STORE structure for certificate validation.
+        uploadStore.reset(X509_STORE_new());
+        if (!uploadStore)
+        {
+            log<level::ERR>("Error occurred during X509_STORE_new call");
+            elog<InternalFailure>();
+        }
+
+        // Certificates from the uploaded data are the only trust anchors.
+        if (X509_STORE_add_cert(uploadStore.get(), content.cert.get()) != 1)
+        {
+            log<level::ERR>("Error occurred during X509_STORE_add_cert call",
+                            entry("FILE=%s", file));
+            elog<InternalFailure>();
+        }
+        for (const auto& cert : content.chain)
+        {
+            // Duplicates within the chain are harmless.
+            X509_STORE_add_cert(uploadStore.get(), cert.get());
+        }
+        ERR_clear_error();
+        anchors = uploadStore.get();
+    }
+    else
+    {
+        // Certificates from the uploaded data may only complete the chain
+        // to one of the anchors.
+        untrusted.reset(sk_X509_new_null());
+        if (!untrusted)
+        {
+            log<level::ERR>("Error occurred during sk_X509_new_null call");
+            elog<InternalFailure>();
+        }
+        for (const auto& cert : content.chain)
+        {
+            if (sk_X509_push(untrusted.get(), cert.get()) == 0)
+            {
+                log<level::ERR>("Error occurred during sk_X509_push call");
+                elog<InternalFailure>();
+            }
+        }
+    }
+
+    X509StoreCtxPtr storeCtx(X509_STORE_CTX_new(), ::X509_STORE_CTX_free);
+    if (!storeCtx)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_CTX_new call",
+                        entry("FILE=%s", file));
+        elog<InternalFailure>();
+    }
+
+    errCode = X509_STORE_CTX_init(storeCtx.get(), anchors, content.cert.get(),
+                                  untrusted.get());
+    if (errCode != 1)
+    {
+        log<level::ERR>("Error occurred during X509_STORE_CTX_init call",
+                        entry("FILE=%s", file));
+        elog<InternalFailure>();
+    }
+    if (!uploadStore && !requireAnchor)
+    {
+        X509_STORE_CTX_set_verify_cb(storeCtx.get(), tolerateTrustChain);
+    }
+
+    // Set time to current time.
+    auto locTime = time(nullptr);
+
+    X509_STORE_CTX_set_time(storeCtx.get(), X509_V_FLAG_USE_CHECK_TIME,
+                            locTime);
+
+    errCode = X509_verify_cert(storeCtx.get());
+    if (errCode == 1)
+    {
+        errCode = X509_V_OK;
+    }
+    else if (errCode == 0)
+    {
+        errCode = X509_STORE_CTX_get_error(storeCtx.get());
+        log<level::INFO>(
+            "Error occurred during X509_verify_cert call, checking for known "
+            "error",
+            entry("FILE=%s", file), entry("ERRCODE=%d", errCode),
+            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
+    }
+    else
+    {
+        log<level::ERR>("Error occurred during X509_verify_cert call",
+                        entry("FILE=%s", file));
+        elog<InternalFailure>();
+    }
+
+    if (requireAnchor && !uploadStore && TRUST_CHAIN_ERR(errCode))
+    {
+        log<level::ERR>(
+            "Certificate does not chain up to a trust anchor",
+            entry("FILE=%s", file), entry("ERRCODE=%d", errCode),
+            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
+        elog<InvalidCertificateError>(
+            InvalidCertificate::REASON("Certificate is not trusted"));
+    }
+
+    // Allow certificate upload, for "certificate is not yet valid" and
+    // trust chain related errors.
+    if (!((errCode == X509_V_OK) ||
+          (errCode == X509_V_ERR_CERT_NOT_YET_VALID) ||
+          TRUST_CHAIN_ERR(errCode)))
+    {
+        if (errCode == X509_V_ERR_CERT_HAS_EXPIRED)
+        {
+            log<level::ERR>("Expired certificate ");
+            elog<InvalidCertificateError>(
+                InvalidCertificate::REASON("Expired Certificate"));
+        }
+        // Logging general error here.
+        log<level::ERR>(
+            "Certificate validation failed", entry("ERRCODE=%d", errCode),
+            entry("ERROR_STR=%s", X509_verify_cert_error_string(errCode)));
+        elog<InvalidCertificateError>(
+            InvalidCertificate::REASON("Certificate validation failed"));
+    }
+
+    validateCertificateStartDate(*content.cert);
+
+    // Verify that the certificate can be used in a TLS context. The shared
+    // context is not modified, the certificate is set on a connection.
+    SSLPtr ssl(SSL_new(CryptoContext::get().tlsContext()), ::SSL_free);
+    if (!ssl)
+    {
+        log<level::ERR>("Error occurred during SSL_new call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+    if (SSL_use_certificate(ssl.get(), content.cert.get()) != 1)
+    {
+        log<level::ERR>("Certificate is not usable",
+                        entry("ERRCODE=%x", ERR_get_error()));
+        elog<InvalidCertificateError>(
+            InvalidCertificate::REASON("Certificate is not usable"));
+    }
+}
+
+// Checks that notBefore is not earlier than the unix epoch given that
+// the corresponding DBus interface is uint64_t.
+void validateCertificateStartDate(X509& cert)
+{
+    int days = 0;
+    int secs = 0;
+
+    ASN1TimePtr epoch(ASN1_TIME_new(), ASN1_STRING_free);
+    // Set time to 00:00am GMT, Jan 1 1970; format: YYYYMMDDHHMMSSZ
+    ASN1_TIME_set_string(epoch.get(), "19700101000000Z");
+
+    ASN1_TIME* notBefore = X509_get_notBefore(&cert);
+    ASN1_TIME_diff(&days, &secs, epoch.get(), notBefore);
+
+    if (days < 0 || secs < 0)
+    {
+        log<level::ERR>("Certificate valid date starts before the Unix Epoch");
+        elog<InvalidCertificateError>(InvalidCertificate::REASON(
+            "NotBefore should after 19700101000000Z"));
+    }
+}
+
+bool compareKeys(X509& cert, EVP_PKEY& privateKey)
+{
+    internal::EVPPkeyPtr pubKey(X509_get_pubkey(&cert), ::EVP_PKEY_free);
+    if (!pubKey)
+    {
+        log<level::ERR>("Error occurred during X509_get_pubkey",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InvalidCertificateError>(
+            InvalidCertificate::REASON("Failed to get public key info"));
+    }
+
+#if (OPENSSL_VERSION_NUMBER < 0x30000000L)
+    int32_t rc = EVP_PKEY_cmp(&privateKey, pubKey.get());
+#else
+    int32_t rc = EVP_PKEY_eq(&privateKey, pubKey.get());
+#endif
+    if (rc != 1)
+    {
+        log<level::ERR>("Private key is not matching with Certificate",
+                        entry("ERRCODE=%d", rc));
+        return false;
+    }
+    return true;
+}
+
+std::string generateCertId(X509& cert)
+{
+    unsigned long subjectNameHash = X509_subject_name_hash(&cert);
+    unsigned long issuerSerialHash = X509_issuer_and_serial_hash(&cert);
+    static constexpr auto CERT_ID_LENGTH = 17;
+    char idBuff[CERT_ID_LENGTH];
+
+    snprintf(idBuff, CERT_ID_LENGTH, "%08lx%08lx", subjectNameHash,
+             issuerSerialHash);
+
+    return std::string(idBuff);
+}
+
+std::string generateCertDigest(X509& cert)
+{
+    std::array<unsigned char, EVP_MAX_MD_SIZE> md{};
+    unsigned int length = 0;
+    if (X509_digest(&cert, CryptoContext::get().sha256(), md.data(),
+                    &length) != 1)
+    {
+        log<level::ERR>("Error occurred during X509_digest call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+
+    return toHex(md.data(), length);
+}
+
+std::string toHex(const unsigned char* data, size_t length)
+{
+    static constexpr char hexDigits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(length * 2);
+    for (size_t i = 0; i < length; ++i)
+    {
+        hex += hexDigits[data[i] >> 4];
+        hex += hexDigits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+std::string generateDataDigest(std::string_view data)
+{
+    std::array<unsigned char, EVP_MAX_MD_SIZE> md{};
+    unsigned int length = 0;
+    if (EVP_Digest(data.data(), data.size(), md.data(), &length,
+                   CryptoContext::get().sha256(), nullptr) != 1)
+    {
+        log<level::ERR>("Error occurred during EVP_Digest call",
+                        entry("ERRCODE=%lu", ERR_get_error()));
+        elog<InternalFailure>();
+    }
+    return toHex(md.data(), length);
+}
+
+std::string generateSubjectNameHash(X509& cert)
+{
+    unsigned long hash = X509_subject_name_hash(&cert);
+    static constexpr auto CERT_HASH_LENGTH = 9;
+    char hashBuf[CERT_HASH_LENGTH];
+
+    snprintf(hashBuf, CERT_HASH_LENGTH, "%08lx", hash);
+
+    return std::string(hashBuf);
+}
+
+} // namespace phosphor::certs
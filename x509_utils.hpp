@@ -0,0 +1,173 @@
+#pragma once
+
+#include <openssl/evp.h>
+#include <openssl/ossl_typ.h>
+#include <openssl/x509.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace phosphor::certs
+{
+
+namespace internal
+{
+using X509Ptr = std::unique_ptr<X509, decltype(&::X509_free)>;
+using EVPPkeyPtr = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
+} // namespace internal
+
+/** @struct CertificateContent
+ *  @brief Certificate file read into memory and decoded exactly once.
+ *  @details Every install stage (verification, private key handling,
+ *  certificate ID generation, property population and the final copy to the
+ *  installation path) works from this context instead of going back to the
+ *  file system.
+ */
+struct CertificateContent
+{
+    /** @brief Path the content was read from, empty if not file backed */
+    std::string sourcePath;
+
+    /** @brief Raw PEM bytes, as they are going to be installed */
+    std::string pem;
+
+    /** @brief First certificate found in the PEM data */
+    internal::X509Ptr cert{nullptr, ::X509_free};
+
+    /** @brief Any further certificates following the first one */
+    std::vector<internal::X509Ptr> chain;
+
+    /** @brief First private key found in the PEM data, if any */
+    internal::EVPPkeyPtr privateKey{nullptr, ::EVP_PKEY_free};
+};
+
+/** @brief Read the whole file into memory.
+ *  @param[in] filePath - File to read.
+ *  @return File contents.
+ */
+std::string readFile(const std::string& filePath);
+
+/** @brief Read everything from a memfd handed over by a client. It has to
+ *  be sealed against writing, shrinking and growing, otherwise
+ *  InvalidArgument is thrown. It is read from the start.
+ *  @param[in] fd - Descriptor to read, stays owned by the caller.
+ *  @return Data read.
+ */
+std::string readFileDescriptor(int fd);
+
+/** @brief Take a copy of a descriptor handed over by a client, to be read
+ *  later with readFileDescriptor(), e.g. on a worker thread.
+ *  @param[in] fd - Descriptor to copy, stays owned by the caller.
+ *  @return Job reading the copy, it is closed with the job.
+ */
+std::function<std::string()> fileDescriptorReader(int fd);
+
+/** @brief Decode certificates and private key from PEM data.
+ *  @param[in] pem - PEM data, moved into the returned context.
+ *  @param[in] sourcePath - Where the data came from, for logging.
+ *  @return Parsed certificate context.
+ */
+CertificateContent parseCertificate(std::string&& pem,
+                                    const std::string& sourcePath);
+
+/** @brief Split a decoded multi-certificate PEM bundle into one context per
+ *  certificate. The other certificates of the bundle are kept as the chain
+ *  of every entry, so intermediates verify against the roots shipped with
+ *  them. The entries are not file backed, each one gets a file of its own
+ *  when installed.
+ *  @param[in] bundle - Parsed bundle.
+ *  @return Parsed certificate contexts, in bundle order.
+ */
+std::vector<CertificateContent> splitBundle(const CertificateContent& bundle);
+
+/** @brief Read and decode certificate file.
+ *  @param[in] filePath - Certificate file path.
+ *  @return Parsed certificate context.
+ */
+CertificateContent loadCertificate(const std::string& filePath);
+
+/** @brief Verify the certificate and check that it can be used in a TLS
+ *  context. Without trust anchors the certificates found in the PEM data
+ *  act as the anchors. With anchors the certificates found in the PEM data
+ *  are only used as intermediates.
+ *  @param[in] content - Parsed certificate context.
+ *  @param[in] anchors - Trust anchors, may be null.
+ *  @param[in] requireAnchor - Reject certificates that do not chain up to
+ *                             one of the given anchors instead of
+ *                             tolerating it.
+ */
+void validateCertificate(const CertificateContent& content,
+                         X509_STORE* anchors = nullptr,
+                         bool requireAnchor = false);
+
+/**
+ * @brief Return error if ceritificate NotBefore date is lt 1970
+ *
+ * Parse the certificate and return error if certificate NotBefore date
+ * is lt 1970.
+ *
+ * @param[in] cert  Reference to certificate object uploaded
+ *
+ * @return void
+ */
+void validateCertificateStartDate(X509& cert);
+
+/** @brief Public/Private key compare function.
+ *  @param[in] cert - Certificate to take the public key from.
+ *  @param[in] privateKey - Private key to compare against.
+ *  @return Return true if Key compare is successful, false if not
+ */
+bool compareKeys(X509& cert, EVP_PKEY& privateKey);
+
+/**
+ * @brief Generate certificate ID based on provided certificate.
+ *
+ * @param[in] cert - Certificate.
+ *
+ * @return Certificate ID as formatted string.
+ */
+std::string generateCertId(X509& cert);
+
+/**
+ * @brief Generate SHA-256 digest of the DER encoded certificate.
+ *
+ * @param[in] cert - Certificate.
+ *
+ * @return Digest as lowercase hex string.
+ */
+std::string generateCertDigest(X509& cert);
+
+/**
+ * @brief Encode binary data, e.g. a digest, as hex string.
+ *
+ * @param[in] data - Data.
+ * @param[in] length - Data length.
+ *
+ * @return Lowercase hex string.
+ */
+std::string toHex(const unsigned char* data, size_t length);
+
+/**
+ * @brief Generate SHA-256 digest of raw data, e.g. a whole certificate file.
+ *
+ * @param[in] data - Data.
+ *
+ * @return Digest as lowercase hex string.
+ */
+std::string generateDataDigest(std::string_view data);
+
+/**
+ * @brief Generate certificate subject name hash as used by OpenSSL for
+ * the CA directory lookup.
+ *
+ * @param[in] cert - Certificate.
+ *
+ * @return Subject name hash as formatted string.
+ */
+std::string generateSubjectNameHash(X509& cert);
+
+} // namespace phosphor::certs